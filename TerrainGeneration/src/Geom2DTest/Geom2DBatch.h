@@ -0,0 +1,500 @@
+#ifndef GEOM_2D_BATCH_H
+#define GEOM_2D_BATCH_H
+
+#include "glm/glm.hpp"
+#include "Geom2DExact.h"
+#include "Geom2DTest.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define GEOM_2D_BATCH_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC compiles the intrinsics of any instruction set as they are, while GCC and Clang need the functions that use them
+// to be compiled for it
+#if defined(GEOM_2D_BATCH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define GEOM_2D_BATCH_TARGET(instructions) __attribute__((target(instructions)))
+#else
+#define GEOM_2D_BATCH_TARGET(instructions)
+#endif
+
+enum class Geom2DBatchKernel
+{
+	SCALAR,		// one case after another
+	AVX2,		// 4 cases per instruction
+	AVX512		// 8 cases per instruction
+};
+
+// Geometric tests of Geom2DTest on batches of cases stored as structure of arrays: case i of a batch takes its points
+// from element i of every array. The floating point filters of the tests are evaluated for several cases per instruction
+// (in double precision, like the scalar ones, so with the same error bounds) and only the cases the filter cannot
+// decide are computed one by one with the adaptive tests, so the results have the same sign as theirs. The instruction
+// set is chosen at run time for the CPU
+namespace Geom2DBatch
+{
+	// Points of a batch (x and z coordinates, as the tests work in the xz plane)
+	struct Points
+	{
+		const float* x;
+		const float* z;
+	};
+
+	// Point i of the batch
+	glm::vec3 Point(const Points& points, size_t i)
+	{
+		return glm::vec3(points.x[i], 0.0f, points.z[i]);
+	}
+
+	// Point in triangle from the orientations of the triangle edges seen from the point (see Geom2DTest::PointInTriangle)
+	uint8_t PointInTriangle(double side1, double side2, double side3)
+	{
+		bool hasNegative = side1 < 0.0 || side2 < 0.0 || side3 < 0.0;
+		bool hasPositive = side1 > 0.0 || side2 > 0.0 || side3 > 0.0;
+
+		return !(hasNegative && hasPositive) ? 1 : 0;
+	}
+
+	namespace Scalar
+	{
+		// Orientation of the cases [begin, end)
+		void Orient2D(const Points& a, const Points& b, const Points& c, size_t begin, size_t end, double* results)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				results[i] = Geom2DTest::Orient2D(Point(a, i), Point(b, i), Point(c, i));
+			}
+		}
+
+		// In circle test of the cases [begin, end)
+		void InCircle(const Points& a, const Points& b, const Points& c, const Points& d, size_t begin, size_t end, double* results)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				results[i] = Geom2DTest::InCircle(Point(a, i), Point(b, i), Point(c, i), Point(d, i));
+			}
+		}
+
+		// Point in triangle of the cases [begin, end)
+		void PointInTriangle(const Points& p, const Points& v1, const Points& v2, const Points& v3, size_t begin, size_t end, uint8_t* results)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				results[i] = Geom2DTest::PointInTriangle(Point(p, i), Point(v1, i), Point(v2, i), Point(v3, i)) ? 1 : 0;
+			}
+		}
+	}
+
+#if defined(GEOM_2D_BATCH_X86)
+
+	namespace Avx2
+	{
+		const size_t NUM_LANES = 4;
+
+		// Coordinates [i, i + 4) of the array, in double precision
+		GEOM_2D_BATCH_TARGET("avx2")
+		__m256d Load(const float* coordinates, size_t i)
+		{
+			return _mm256_cvtps_pd(_mm_loadu_ps(coordinates + i));
+		}
+
+		// Absolute value
+		GEOM_2D_BATCH_TARGET("avx2")
+		__m256d Abs(__m256d value)
+		{
+			return _mm256_andnot_pd(_mm256_set1_pd(-0.0), value);
+		}
+
+		// Orientation filter of the cases [i, i + 4): the determinants, with a bit set in uncertain for every lane where
+		// the filter cannot decide the sign
+		GEOM_2D_BATCH_TARGET("avx2")
+		__m256d Orient2DFilter(const Points& a, const Points& b, const Points& c, size_t i, int& uncertain)
+		{
+			__m256d cx = Load(c.x, i);
+			__m256d cz = Load(c.z, i);
+
+			__m256d detLeft = _mm256_mul_pd(_mm256_sub_pd(Load(a.x, i), cx), _mm256_sub_pd(Load(b.z, i), cz));
+			__m256d detRight = _mm256_mul_pd(_mm256_sub_pd(Load(a.z, i), cz), _mm256_sub_pd(Load(b.x, i), cx));
+			__m256d det = _mm256_sub_pd(detLeft, detRight);
+
+			__m256d errorBound = _mm256_mul_pd(_mm256_set1_pd(Geom2DExact::ORIENT_ERROR_BOUND), _mm256_add_pd(Abs(detLeft), Abs(detRight)));
+			uncertain = _mm256_movemask_pd(_mm256_cmp_pd(Abs(det), errorBound, _CMP_LT_OQ));
+
+			return det;
+		}
+
+		// Orientation of the cases [begin, end)
+		GEOM_2D_BATCH_TARGET("avx2")
+		void Orient2D(const Points& a, const Points& b, const Points& c, size_t begin, size_t end, double* results)
+		{
+			size_t i = begin;
+			for (; i + NUM_LANES <= end; i += NUM_LANES)
+			{
+				int uncertain;
+				_mm256_storeu_pd(results + i, Orient2DFilter(a, b, c, i, uncertain));
+
+				for (size_t lane = 0; uncertain != 0; lane++, uncertain >>= 1)
+				{
+					if (uncertain & 1)
+					{
+						Scalar::Orient2D(a, b, c, i + lane, i + lane + 1, results);
+					}
+				}
+			}
+
+			Scalar::Orient2D(a, b, c, i, end, results);
+		}
+
+		// In circle test of the cases [begin, end)
+		GEOM_2D_BATCH_TARGET("avx2")
+		void InCircle(const Points& a, const Points& b, const Points& c, const Points& d, size_t begin, size_t end, double* results)
+		{
+			size_t i = begin;
+			for (; i + NUM_LANES <= end; i += NUM_LANES)
+			{
+				__m256d dx = Load(d.x, i);
+				__m256d dz = Load(d.z, i);
+
+				__m256d adx = _mm256_sub_pd(Load(a.x, i), dx);
+				__m256d bdx = _mm256_sub_pd(Load(b.x, i), dx);
+				__m256d cdx = _mm256_sub_pd(Load(c.x, i), dx);
+				__m256d adz = _mm256_sub_pd(Load(a.z, i), dz);
+				__m256d bdz = _mm256_sub_pd(Load(b.z, i), dz);
+				__m256d cdz = _mm256_sub_pd(Load(c.z, i), dz);
+
+				__m256d bdxcdz = _mm256_mul_pd(bdx, cdz);
+				__m256d cdxbdz = _mm256_mul_pd(cdx, bdz);
+				__m256d aLift = _mm256_add_pd(_mm256_mul_pd(adx, adx), _mm256_mul_pd(adz, adz));
+
+				__m256d cdxadz = _mm256_mul_pd(cdx, adz);
+				__m256d adxcdz = _mm256_mul_pd(adx, cdz);
+				__m256d bLift = _mm256_add_pd(_mm256_mul_pd(bdx, bdx), _mm256_mul_pd(bdz, bdz));
+
+				__m256d adxbdz = _mm256_mul_pd(adx, bdz);
+				__m256d bdxadz = _mm256_mul_pd(bdx, adz);
+				__m256d cLift = _mm256_add_pd(_mm256_mul_pd(cdx, cdx), _mm256_mul_pd(cdz, cdz));
+
+				__m256d det = _mm256_add_pd(_mm256_add_pd(
+					_mm256_mul_pd(aLift, _mm256_sub_pd(bdxcdz, cdxbdz)),
+					_mm256_mul_pd(bLift, _mm256_sub_pd(cdxadz, adxcdz))),
+					_mm256_mul_pd(cLift, _mm256_sub_pd(adxbdz, bdxadz)));
+
+				__m256d permanent = _mm256_add_pd(_mm256_add_pd(
+					_mm256_mul_pd(_mm256_add_pd(Abs(bdxcdz), Abs(cdxbdz)), aLift),
+					_mm256_mul_pd(_mm256_add_pd(Abs(cdxadz), Abs(adxcdz)), bLift)),
+					_mm256_mul_pd(_mm256_add_pd(Abs(adxbdz), Abs(bdxadz)), cLift));
+
+				__m256d errorBound = _mm256_mul_pd(_mm256_set1_pd(Geom2DExact::INCIRCLE_ERROR_BOUND), permanent);
+				int uncertain = _mm256_movemask_pd(_mm256_cmp_pd(Abs(det), errorBound, _CMP_LE_OQ));
+
+				_mm256_storeu_pd(results + i, det);
+
+				for (size_t lane = 0; uncertain != 0; lane++, uncertain >>= 1)
+				{
+					if (uncertain & 1)
+					{
+						Scalar::InCircle(a, b, c, d, i + lane, i + lane + 1, results);
+					}
+				}
+			}
+
+			Scalar::InCircle(a, b, c, d, i, end, results);
+		}
+
+		// Point in triangle of the cases [begin, end)
+		GEOM_2D_BATCH_TARGET("avx2")
+		void PointInTriangle(const Points& p, const Points& v1, const Points& v2, const Points& v3, size_t begin, size_t end, uint8_t* results)
+		{
+			size_t i = begin;
+			for (; i + NUM_LANES <= end; i += NUM_LANES)
+			{
+				const Points* edges[3][2] = { { &v1, &v2 }, { &v2, &v3 }, { &v3, &v1 } };
+
+				double sides[3][NUM_LANES];
+				for (int edge = 0; edge < 3; edge++)
+				{
+					int uncertain;
+					_mm256_storeu_pd(sides[edge], Orient2DFilter(*edges[edge][0], *edges[edge][1], p, i, uncertain));
+
+					for (size_t lane = 0; uncertain != 0; lane++, uncertain >>= 1)
+					{
+						if (uncertain & 1)
+						{
+							sides[edge][lane] = Geom2DTest::Orient2D(Point(*edges[edge][0], i + lane), Point(*edges[edge][1], i + lane), Point(p, i + lane));
+						}
+					}
+				}
+
+				for (size_t lane = 0; lane < NUM_LANES; lane++)
+				{
+					results[i + lane] = Geom2DBatch::PointInTriangle(sides[0][lane], sides[1][lane], sides[2][lane]);
+				}
+			}
+
+			Scalar::PointInTriangle(p, v1, v2, v3, i, end, results);
+		}
+	}
+
+	namespace Avx512
+	{
+		const size_t NUM_LANES = 8;
+
+		// Coordinates [i, i + 8) of the array, in double precision
+		GEOM_2D_BATCH_TARGET("avx512f")
+		__m512d Load(const float* coordinates, size_t i)
+		{
+			return _mm512_cvtps_pd(_mm256_loadu_ps(coordinates + i));
+		}
+
+		// Orientation filter of the cases [i, i + 8): the determinants, with a bit set in uncertain for every lane where
+		// the filter cannot decide the sign
+		GEOM_2D_BATCH_TARGET("avx512f")
+		__m512d Orient2DFilter(const Points& a, const Points& b, const Points& c, size_t i, int& uncertain)
+		{
+			__m512d cx = Load(c.x, i);
+			__m512d cz = Load(c.z, i);
+
+			__m512d detLeft = _mm512_mul_pd(_mm512_sub_pd(Load(a.x, i), cx), _mm512_sub_pd(Load(b.z, i), cz));
+			__m512d detRight = _mm512_mul_pd(_mm512_sub_pd(Load(a.z, i), cz), _mm512_sub_pd(Load(b.x, i), cx));
+			__m512d det = _mm512_sub_pd(detLeft, detRight);
+
+			__m512d errorBound = _mm512_mul_pd(_mm512_set1_pd(Geom2DExact::ORIENT_ERROR_BOUND), _mm512_add_pd(_mm512_abs_pd(detLeft), _mm512_abs_pd(detRight)));
+			uncertain = (int)_mm512_cmp_pd_mask(_mm512_abs_pd(det), errorBound, _CMP_LT_OQ);
+
+			return det;
+		}
+
+		// Orientation of the cases [begin, end)
+		GEOM_2D_BATCH_TARGET("avx512f")
+		void Orient2D(const Points& a, const Points& b, const Points& c, size_t begin, size_t end, double* results)
+		{
+			size_t i = begin;
+			for (; i + NUM_LANES <= end; i += NUM_LANES)
+			{
+				int uncertain;
+				_mm512_storeu_pd(results + i, Orient2DFilter(a, b, c, i, uncertain));
+
+				for (size_t lane = 0; uncertain != 0; lane++, uncertain >>= 1)
+				{
+					if (uncertain & 1)
+					{
+						Scalar::Orient2D(a, b, c, i + lane, i + lane + 1, results);
+					}
+				}
+			}
+
+			Scalar::Orient2D(a, b, c, i, end, results);
+		}
+
+		// In circle test of the cases [begin, end)
+		GEOM_2D_BATCH_TARGET("avx512f")
+		void InCircle(const Points& a, const Points& b, const Points& c, const Points& d, size_t begin, size_t end, double* results)
+		{
+			size_t i = begin;
+			for (; i + NUM_LANES <= end; i += NUM_LANES)
+			{
+				__m512d dx = Load(d.x, i);
+				__m512d dz = Load(d.z, i);
+
+				__m512d adx = _mm512_sub_pd(Load(a.x, i), dx);
+				__m512d bdx = _mm512_sub_pd(Load(b.x, i), dx);
+				__m512d cdx = _mm512_sub_pd(Load(c.x, i), dx);
+				__m512d adz = _mm512_sub_pd(Load(a.z, i), dz);
+				__m512d bdz = _mm512_sub_pd(Load(b.z, i), dz);
+				__m512d cdz = _mm512_sub_pd(Load(c.z, i), dz);
+
+				__m512d bdxcdz = _mm512_mul_pd(bdx, cdz);
+				__m512d cdxbdz = _mm512_mul_pd(cdx, bdz);
+				__m512d aLift = _mm512_add_pd(_mm512_mul_pd(adx, adx), _mm512_mul_pd(adz, adz));
+
+				__m512d cdxadz = _mm512_mul_pd(cdx, adz);
+				__m512d adxcdz = _mm512_mul_pd(adx, cdz);
+				__m512d bLift = _mm512_add_pd(_mm512_mul_pd(bdx, bdx), _mm512_mul_pd(bdz, bdz));
+
+				__m512d adxbdz = _mm512_mul_pd(adx, bdz);
+				__m512d bdxadz = _mm512_mul_pd(bdx, adz);
+				__m512d cLift = _mm512_add_pd(_mm512_mul_pd(cdx, cdx), _mm512_mul_pd(cdz, cdz));
+
+				__m512d det = _mm512_add_pd(_mm512_add_pd(
+					_mm512_mul_pd(aLift, _mm512_sub_pd(bdxcdz, cdxbdz)),
+					_mm512_mul_pd(bLift, _mm512_sub_pd(cdxadz, adxcdz))),
+					_mm512_mul_pd(cLift, _mm512_sub_pd(adxbdz, bdxadz)));
+
+				__m512d permanent = _mm512_add_pd(_mm512_add_pd(
+					_mm512_mul_pd(_mm512_add_pd(_mm512_abs_pd(bdxcdz), _mm512_abs_pd(cdxbdz)), aLift),
+					_mm512_mul_pd(_mm512_add_pd(_mm512_abs_pd(cdxadz), _mm512_abs_pd(adxcdz)), bLift)),
+					_mm512_mul_pd(_mm512_add_pd(_mm512_abs_pd(adxbdz), _mm512_abs_pd(bdxadz)), cLift));
+
+				__m512d errorBound = _mm512_mul_pd(_mm512_set1_pd(Geom2DExact::INCIRCLE_ERROR_BOUND), permanent);
+				int uncertain = (int)_mm512_cmp_pd_mask(_mm512_abs_pd(det), errorBound, _CMP_LE_OQ);
+
+				_mm512_storeu_pd(results + i, det);
+
+				for (size_t lane = 0; uncertain != 0; lane++, uncertain >>= 1)
+				{
+					if (uncertain & 1)
+					{
+						Scalar::InCircle(a, b, c, d, i + lane, i + lane + 1, results);
+					}
+				}
+			}
+
+			Scalar::InCircle(a, b, c, d, i, end, results);
+		}
+
+		// Point in triangle of the cases [begin, end)
+		GEOM_2D_BATCH_TARGET("avx512f")
+		void PointInTriangle(const Points& p, const Points& v1, const Points& v2, const Points& v3, size_t begin, size_t end, uint8_t* results)
+		{
+			size_t i = begin;
+			for (; i + NUM_LANES <= end; i += NUM_LANES)
+			{
+				const Points* edges[3][2] = { { &v1, &v2 }, { &v2, &v3 }, { &v3, &v1 } };
+
+				double sides[3][NUM_LANES];
+				for (int edge = 0; edge < 3; edge++)
+				{
+					int uncertain;
+					_mm512_storeu_pd(sides[edge], Orient2DFilter(*edges[edge][0], *edges[edge][1], p, i, uncertain));
+
+					for (size_t lane = 0; uncertain != 0; lane++, uncertain >>= 1)
+					{
+						if (uncertain & 1)
+						{
+							sides[edge][lane] = Geom2DTest::Orient2D(Point(*edges[edge][0], i + lane), Point(*edges[edge][1], i + lane), Point(p, i + lane));
+						}
+					}
+				}
+
+				for (size_t lane = 0; lane < NUM_LANES; lane++)
+				{
+					results[i + lane] = Geom2DBatch::PointInTriangle(sides[0][lane], sides[1][lane], sides[2][lane]);
+				}
+			}
+
+			Scalar::PointInTriangle(p, v1, v2, v3, i, end, results);
+		}
+	}
+
+#endif
+
+	// Widest kernel the CPU (and the operating system, which has to save the wider registers) supports
+	Geom2DBatchKernel DetectKernel()
+	{
+#if defined(GEOM_2D_BATCH_X86)
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+		{
+			return Geom2DBatchKernel::SCALAR;
+		}
+
+		// AVX and the registers saved by the operating system (XSAVE enabled)
+		__cpuid(info, 1);
+		if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+		{
+			return Geom2DBatchKernel::SCALAR;
+		}
+
+		unsigned long long enabledStates = _xgetbv(0);
+		__cpuidex(info, 7, 0);
+
+		// AVX-512F with the opmask and upper ZMM states, AVX2 with the XMM and YMM states
+		if ((info[1] & (1 << 16)) != 0 && (enabledStates & 0xE6) == 0xE6)
+		{
+			return Geom2DBatchKernel::AVX512;
+		}
+
+		if ((info[1] & (1 << 5)) != 0 && (enabledStates & 0x6) == 0x6)
+		{
+			return Geom2DBatchKernel::AVX2;
+		}
+#else
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f"))
+		{
+			return Geom2DBatchKernel::AVX512;
+		}
+
+		if (__builtin_cpu_supports("avx2"))
+		{
+			return Geom2DBatchKernel::AVX2;
+		}
+#endif
+#endif
+		return Geom2DBatchKernel::SCALAR;
+	}
+
+	// Kernel used by the batched tests (detected once)
+	Geom2DBatchKernel Kernel()
+	{
+		static const Geom2DBatchKernel kernel = DetectKernel();
+		return kernel;
+	}
+
+	// Orientation of the triangles (a[i], b[i], c[i]) (see Geom2DTest::Orient2D)
+	void Orient2D(const Points& a, const Points& b, const Points& c, size_t count, double* results)
+	{
+		switch (Kernel())
+		{
+#if defined(GEOM_2D_BATCH_X86)
+		case Geom2DBatchKernel::AVX512:
+			Avx512::Orient2D(a, b, c, 0, count, results);
+			break;
+		case Geom2DBatchKernel::AVX2:
+			Avx2::Orient2D(a, b, c, 0, count, results);
+			break;
+#endif
+		default:
+			Scalar::Orient2D(a, b, c, 0, count, results);
+			break;
+		}
+	}
+
+	// In circle test of the points d[i] against the triangles (a[i], b[i], c[i]) (see Geom2DTest::InCircle)
+	void InCircle(const Points& a, const Points& b, const Points& c, const Points& d, size_t count, double* results)
+	{
+		switch (Kernel())
+		{
+#if defined(GEOM_2D_BATCH_X86)
+		case Geom2DBatchKernel::AVX512:
+			Avx512::InCircle(a, b, c, d, 0, count, results);
+			break;
+		case Geom2DBatchKernel::AVX2:
+			Avx2::InCircle(a, b, c, d, 0, count, results);
+			break;
+#endif
+		default:
+			Scalar::InCircle(a, b, c, d, 0, count, results);
+			break;
+		}
+	}
+
+	// Points p[i] in the triangles (v1[i], v2[i], v3[i]), 1 inside or on the boundary and 0 outside (see
+	// Geom2DTest::PointInTriangle)
+	void PointInTriangle(const Points& p, const Points& v1, const Points& v2, const Points& v3, size_t count, uint8_t* results)
+	{
+		switch (Kernel())
+		{
+#if defined(GEOM_2D_BATCH_X86)
+		case Geom2DBatchKernel::AVX512:
+			Avx512::PointInTriangle(p, v1, v2, v3, 0, count, results);
+			break;
+		case Geom2DBatchKernel::AVX2:
+			Avx2::PointInTriangle(p, v1, v2, v3, 0, count, results);
+			break;
+#endif
+		default:
+			Scalar::PointInTriangle(p, v1, v2, v3, 0, count, results);
+			break;
+		}
+	}
+}
+
+#endif // !GEOM_2D_BATCH_H
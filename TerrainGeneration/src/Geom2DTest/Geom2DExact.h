@@ -0,0 +1,262 @@
+#ifndef GEOM_2D_EXACT_H
+#define GEOM_2D_EXACT_H
+
+#include <cmath>
+
+// Exact floating point arithmetic on expansions (Shewchuk, "Adaptive Precision Floating-Point Arithmetic and Fast
+// Robust Geometric Predicates"). An expansion is an array of doubles sorted by increasing magnitude whose sum is
+// represented exactly; its sign is the sign of its last (largest) component
+namespace Geom2DExact
+{
+	// 2^-53, machine epsilon of a double used in the error bounds
+	const double EPSILON = 1.1102230246251565e-16;
+
+	// 2^27 + 1, used to split a double into two 26-bit halves
+	const double SPLITTER = 134217729.0;
+
+	// error bounds of the floating point filters
+	const double ORIENT_ERROR_BOUND = (3.0 + 16.0 * EPSILON) * EPSILON;
+	const double INCIRCLE_ERROR_BOUND = (10.0 + 96.0 * EPSILON) * EPSILON;
+
+	// maximum length of the expansions handled by ExpansionProduct
+	const int MAX_EXPANSION_LENGTH = 1024;
+
+	// x + y = a + b exactly, requires |a| >= |b|
+	void FastTwoSum(double a, double b, double& x, double& y)
+	{
+		x = a + b;
+		double bVirtual = x - a;
+		y = b - bVirtual;
+	}
+
+	// x + y = a + b exactly
+	void TwoSum(double a, double b, double& x, double& y)
+	{
+		x = a + b;
+		double bVirtual = x - a;
+		double aVirtual = x - bVirtual;
+		double bRoundoff = b - bVirtual;
+		double aRoundoff = a - aVirtual;
+		y = aRoundoff + bRoundoff;
+	}
+
+	// x + y = a - b exactly
+	void TwoDiff(double a, double b, double& x, double& y)
+	{
+		x = a - b;
+		double bVirtual = a - x;
+		double aVirtual = x + bVirtual;
+		double bRoundoff = bVirtual - b;
+		double aRoundoff = a - aVirtual;
+		y = aRoundoff + bRoundoff;
+	}
+
+	// hi + lo = a, with both halves fitting in 26 bits
+	void Split(double a, double& hi, double& lo)
+	{
+		double c = SPLITTER * a;
+		double aBig = c - a;
+		hi = c - aBig;
+		lo = a - hi;
+	}
+
+	// x + y = a * b exactly, with b already split
+	void TwoProductPresplit(double a, double b, double bHi, double bLo, double& x, double& y)
+	{
+		x = a * b;
+
+		double aHi, aLo;
+		Split(a, aHi, aLo);
+
+		double error1 = x - (aHi * bHi);
+		double error2 = error1 - (aLo * bHi);
+		double error3 = error2 - (aHi * bLo);
+		y = (aLo * bLo) - error3;
+	}
+
+	// x + y = a * b exactly
+	void TwoProduct(double a, double b, double& x, double& y)
+	{
+		double bHi, bLo;
+		Split(b, bHi, bLo);
+		TwoProductPresplit(a, b, bHi, bLo, x, y);
+	}
+
+	// Expansion holding a - b exactly. Returns its length
+	int Difference(double a, double b, double* h)
+	{
+		double x, y;
+		TwoDiff(a, b, x, y);
+
+		if (y == 0.0)
+		{
+			h[0] = x;
+			return 1;
+		}
+
+		h[0] = y;
+		h[1] = x;
+		return 2;
+	}
+
+	// h = e + f, with zero components removed. Returns the length of h
+	int ExpansionSum(const double* e, int eLength, const double* f, int fLength, double* h)
+	{
+		int eIndex = 0;
+		int fIndex = 0;
+		double eNow = e[0];
+		double fNow = f[0];
+
+		double Q, QNew, hh;
+		if ((fNow > eNow) == (fNow > -eNow))
+		{
+			Q = eNow;
+			eNow = (++eIndex < eLength) ? e[eIndex] : 0.0;
+		}
+		else
+		{
+			Q = fNow;
+			fNow = (++fIndex < fLength) ? f[fIndex] : 0.0;
+		}
+
+		int hIndex = 0;
+		if (eIndex < eLength && fIndex < fLength)
+		{
+			if ((fNow > eNow) == (fNow > -eNow))
+			{
+				FastTwoSum(eNow, Q, QNew, hh);
+				eNow = (++eIndex < eLength) ? e[eIndex] : 0.0;
+			}
+			else
+			{
+				FastTwoSum(fNow, Q, QNew, hh);
+				fNow = (++fIndex < fLength) ? f[fIndex] : 0.0;
+			}
+			Q = QNew;
+			if (hh != 0.0)
+			{
+				h[hIndex++] = hh;
+			}
+
+			while (eIndex < eLength && fIndex < fLength)
+			{
+				if ((fNow > eNow) == (fNow > -eNow))
+				{
+					TwoSum(Q, eNow, QNew, hh);
+					eNow = (++eIndex < eLength) ? e[eIndex] : 0.0;
+				}
+				else
+				{
+					TwoSum(Q, fNow, QNew, hh);
+					fNow = (++fIndex < fLength) ? f[fIndex] : 0.0;
+				}
+				Q = QNew;
+				if (hh != 0.0)
+				{
+					h[hIndex++] = hh;
+				}
+			}
+		}
+
+		while (eIndex < eLength)
+		{
+			TwoSum(Q, eNow, QNew, hh);
+			eNow = (++eIndex < eLength) ? e[eIndex] : 0.0;
+			Q = QNew;
+			if (hh != 0.0)
+			{
+				h[hIndex++] = hh;
+			}
+		}
+
+		while (fIndex < fLength)
+		{
+			TwoSum(Q, fNow, QNew, hh);
+			fNow = (++fIndex < fLength) ? f[fIndex] : 0.0;
+			Q = QNew;
+			if (hh != 0.0)
+			{
+				h[hIndex++] = hh;
+			}
+		}
+
+		if (Q != 0.0 || hIndex == 0)
+		{
+			h[hIndex++] = Q;
+		}
+
+		return hIndex;
+	}
+
+	// h = e * b, with zero components removed. Returns the length of h
+	int ScaleExpansion(const double* e, int eLength, double b, double* h)
+	{
+		double bHi, bLo;
+		Split(b, bHi, bLo);
+
+		double Q, hh;
+		TwoProductPresplit(e[0], b, bHi, bLo, Q, hh);
+
+		int hIndex = 0;
+		if (hh != 0.0)
+		{
+			h[hIndex++] = hh;
+		}
+
+		for (int eIndex = 1; eIndex < eLength; eIndex++)
+		{
+			double product1, product0, sum;
+			TwoProductPresplit(e[eIndex], b, bHi, bLo, product1, product0);
+			TwoSum(Q, product0, sum, hh);
+			if (hh != 0.0)
+			{
+				h[hIndex++] = hh;
+			}
+			FastTwoSum(product1, sum, Q, hh);
+			if (hh != 0.0)
+			{
+				h[hIndex++] = hh;
+			}
+		}
+
+		if (Q != 0.0 || hIndex == 0)
+		{
+			h[hIndex++] = Q;
+		}
+
+		return hIndex;
+	}
+
+	// h = e * f. The result can be as long as 2 * eLength * fLength (up to MAX_EXPANSION_LENGTH)
+	int ExpansionProduct(const double* e, int eLength, const double* f, int fLength, double* h)
+	{
+		double scaled[MAX_EXPANSION_LENGTH];
+		double accumulated[MAX_EXPANSION_LENGTH];
+
+		int hLength = ScaleExpansion(e, eLength, f[0], h);
+		for (int i = 1; i < fLength; i++)
+		{
+			int scaledLength = ScaleExpansion(e, eLength, f[i], scaled);
+			int accumulatedLength = ExpansionSum(h, hLength, scaled, scaledLength, accumulated);
+
+			for (int j = 0; j < accumulatedLength; j++)
+			{
+				h[j] = accumulated[j];
+			}
+			hLength = accumulatedLength;
+		}
+
+		return hLength;
+	}
+
+	// e = -e
+	void Negate(double* e, int eLength)
+	{
+		for (int i = 0; i < eLength; i++)
+		{
+			e[i] = -e[i];
+		}
+	}
+}
+
+#endif // !GEOM_2D_EXACT_H
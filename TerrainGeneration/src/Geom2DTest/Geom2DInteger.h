@@ -0,0 +1,108 @@
+#ifndef GEOM_2D_INTEGER_H
+#define GEOM_2D_INTEGER_H
+
+#include <cstdint>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+// Exact integer arithmetic for the predicates of points on an integer lattice. With coordinates below 2^29 in magnitude
+// the orientation determinant fits in 64 bits and the in circle one in 128 bits, so no floating point filter is needed.
+// The 128-bit integers are the compiler ones when there are, and two 64-bit words otherwise
+namespace Geom2DInteger
+{
+	// Lattice coordinate of the coordinate (which must be an integer once scaled by the scale of the lattice, a power of 2)
+	int64_t LatticeCoordinate(float coordinate, float scale)
+	{
+		return (int64_t)(coordinate * scale);
+	}
+
+#if defined(__SIZEOF_INT128__)
+
+	typedef __int128 Int128;
+
+	// a * b
+	Int128 Multiply(int64_t a, int64_t b)
+	{
+		return (Int128)a * b;
+	}
+
+	// a + b
+	Int128 Add(const Int128& a, const Int128& b)
+	{
+		return a + b;
+	}
+
+	// Sign of a (-1, 0 or 1)
+	int Sign(const Int128& a)
+	{
+		return (a > 0) - (a < 0);
+	}
+
+#else
+
+	// 128-bit two's complement integer
+	struct Int128
+	{
+		uint64_t lo;
+		uint64_t hi;
+	};
+
+	// (hi, lo) = a * b, unsigned
+	void MultiplyUnsigned(uint64_t a, uint64_t b, uint64_t& lo, uint64_t& hi)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		lo = _umul128(a, b, &hi);
+#else
+		uint64_t aLo = a & 0xFFFFFFFF, aHi = a >> 32;
+		uint64_t bLo = b & 0xFFFFFFFF, bHi = b >> 32;
+
+		uint64_t loLo = aLo * bLo;
+		uint64_t hiLo = aHi * bLo;
+		uint64_t loHi = aLo * bHi;
+		uint64_t hiHi = aHi * bHi;
+
+		uint64_t middle = (loLo >> 32) + (hiLo & 0xFFFFFFFF) + (loHi & 0xFFFFFFFF);
+		lo = (middle << 32) | (loLo & 0xFFFFFFFF);
+		hi = hiHi + (hiLo >> 32) + (loHi >> 32) + (middle >> 32);
+#endif
+	}
+
+	// a * b
+	Int128 Multiply(int64_t a, int64_t b)
+	{
+		Int128 product;
+		MultiplyUnsigned((uint64_t)a, (uint64_t)b, product.lo, product.hi);
+
+		// the unsigned product of the two's complement values is off by 2^64 times the other value for each negative one
+		product.hi -= ((uint64_t)b & (uint64_t)(a >> 63)) + ((uint64_t)a & (uint64_t)(b >> 63));
+
+		return product;
+	}
+
+	// a + b
+	Int128 Add(const Int128& a, const Int128& b)
+	{
+		Int128 sum;
+		sum.lo = a.lo + b.lo;
+		sum.hi = a.hi + b.hi + (sum.lo < a.lo ? 1 : 0);
+
+		return sum;
+	}
+
+	// Sign of a (-1, 0 or 1)
+	int Sign(const Int128& a)
+	{
+		if ((int64_t)a.hi < 0)
+		{
+			return -1;
+		}
+
+		return (a.hi | a.lo) != 0 ? 1 : 0;
+	}
+
+#endif
+}
+
+#endif // !GEOM_2D_INTEGER_H
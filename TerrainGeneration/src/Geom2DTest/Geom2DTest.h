@@ -2,6 +2,11 @@
 #define GEOM_2D_TEST_H
 
 #include "glm/glm.hpp"
+#include "Geom2DExact.h"
+#include "Geom2DInteger.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace Geom2DTest
 {
@@ -32,88 +37,247 @@ namespace Geom2DTest
 		return((A * p.x + B * p.z + C) * (A * p.x + B * p.z + C) / (A * A + B * B));
 	}
 
-	// Point in circle
-	bool PointInCircle(const glm::vec3& p, const glm::vec3& c, float r)
+	// Exact orientation of the triangle (a, b, c) in the xz plane (the sign of the returned value is exact)
+	double Orient2DExact(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
 	{
-		float x = p.x - c.x;
-		float z = p.z - c.z;
+		// the coordinates are floats, so every product below is exact in double precision and only the sum
+		// needs expansion arithmetic
+		double terms[6] =
+		{
+			(double)a.x * b.z, -(double)a.x * c.z, -(double)a.z * b.x,
+			(double)a.z * c.x, (double)b.x * c.z, -(double)b.z * c.x
+		};
+
+		double sum[6];
+		double next[7];
+		int sumLength = 1;
+		sum[0] = terms[0];
+		for (int i = 1; i < 6; i++)
+		{
+			int nextLength = Geom2DExact::ExpansionSum(sum, sumLength, &terms[i], 1, next);
+			std::copy(next, next + nextLength, sum);
+			sumLength = nextLength;
+		}
 
-		return (x*x + z*z <= r * r);
+		return sum[sumLength - 1];
 	}
 
-	// Point in triangle
-	bool PointInTriangle(const glm::vec3& p, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& v3)
+	// Orientation of the triangle (a, b, c) in the xz plane (> 0 counter-clockwise, < 0 clockwise, 0 collinear).
+	// Adaptive: a floating point filter decides most cases and only the uncertain ones are computed exactly
+	double Orient2D(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
 	{
-		float A1, B1, C1;
-		float A2, B2, C2;
-		float A3, B3, C3;
+		double detLeft = ((double)a.x - c.x) * ((double)b.z - c.z);
+		double detRight = ((double)a.z - c.z) * ((double)b.x - c.x);
+		double det = detLeft - detRight;
 
-		GetLine(v1, v2, A1, B1, C1);
-		GetLine(v2, v3, A2, B2, C2);
-		GetLine(v3, v1, A3, B3, C3);
+		double detSum;
+		if (detLeft > 0.0)
+		{
+			if (detRight <= 0.0)
+			{
+				return det;
+			}
+			detSum = detLeft + detRight;
+		}
+		else if (detLeft < 0.0)
+		{
+			if (detRight >= 0.0)
+			{
+				return det;
+			}
+			detSum = -detLeft - detRight;
+		}
+		else
+		{
+			return det;
+		}
 
-		bool sign1, sign2, sign3;
+		double errorBound = Geom2DExact::ORIENT_ERROR_BOUND * detSum;
+		if (det >= errorBound || -det >= errorBound)
+		{
+			return det;
+		}
 
-		sign1 = ((A1 * p.x) + (B1 * p.z) + C1) > 0;
-		sign2 = ((A2 * p.x) + (B2 * p.z) + C2) > 0;
-		sign3 = ((A3 * p.x) + (B3 * p.z) + C3) > 0;
+		return Orient2DExact(a, b, c);
+	}
 
-		return (sign1 == sign2 && sign2 == sign3);
+	// Exact in circle test of the point d against the triangle (a, b, c) in the xz plane (the sign of the returned value is exact)
+	double InCircleExact(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d)
+	{
+		using namespace Geom2DExact;
+
+		// coordinates relative to d
+		double adx[2], adz[2], bdx[2], bdz[2], cdx[2], cdz[2];
+		int adxLength = Difference(a.x, d.x, adx);
+		int adzLength = Difference(a.z, d.z, adz);
+		int bdxLength = Difference(b.x, d.x, bdx);
+		int bdzLength = Difference(b.z, d.z, bdz);
+		int cdxLength = Difference(c.x, d.x, cdx);
+		int cdzLength = Difference(c.z, d.z, cdz);
+
+		double left[8], right[8];
+		int leftLength, rightLength;
+
+		// bc = bdx * cdz - cdx * bdz
+		double bc[16];
+		leftLength = ExpansionProduct(bdx, bdxLength, cdz, cdzLength, left);
+		rightLength = ExpansionProduct(cdx, cdxLength, bdz, bdzLength, right);
+		Negate(right, rightLength);
+		int bcLength = ExpansionSum(left, leftLength, right, rightLength, bc);
+
+		// ca = cdx * adz - adx * cdz
+		double ca[16];
+		leftLength = ExpansionProduct(cdx, cdxLength, adz, adzLength, left);
+		rightLength = ExpansionProduct(adx, adxLength, cdz, cdzLength, right);
+		Negate(right, rightLength);
+		int caLength = ExpansionSum(left, leftLength, right, rightLength, ca);
+
+		// ab = adx * bdz - bdx * adz
+		double ab[16];
+		leftLength = ExpansionProduct(adx, adxLength, bdz, bdzLength, left);
+		rightLength = ExpansionProduct(bdx, bdxLength, adz, adzLength, right);
+		Negate(right, rightLength);
+		int abLength = ExpansionSum(left, leftLength, right, rightLength, ab);
+
+		// lifts (squared distances to d)
+		double aLift[16], bLift[16], cLift[16];
+		leftLength = ExpansionProduct(adx, adxLength, adx, adxLength, left);
+		rightLength = ExpansionProduct(adz, adzLength, adz, adzLength, right);
+		int aLiftLength = ExpansionSum(left, leftLength, right, rightLength, aLift);
+
+		leftLength = ExpansionProduct(bdx, bdxLength, bdx, bdxLength, left);
+		rightLength = ExpansionProduct(bdz, bdzLength, bdz, bdzLength, right);
+		int bLiftLength = ExpansionSum(left, leftLength, right, rightLength, bLift);
+
+		leftLength = ExpansionProduct(cdx, cdxLength, cdx, cdxLength, left);
+		rightLength = ExpansionProduct(cdz, cdzLength, cdz, cdzLength, right);
+		int cLiftLength = ExpansionSum(left, leftLength, right, rightLength, cLift);
+
+		// det = aLift * bc + bLift * ca + cLift * ab
+		double aDet[512], bDet[512], cDet[512];
+		int aDetLength = ExpansionProduct(aLift, aLiftLength, bc, bcLength, aDet);
+		int bDetLength = ExpansionProduct(bLift, bLiftLength, ca, caLength, bDet);
+		int cDetLength = ExpansionProduct(cLift, cLiftLength, ab, abLength, cDet);
+
+		double abDet[1024];
+		int abDetLength = ExpansionSum(aDet, aDetLength, bDet, bDetLength, abDet);
+
+		double det[1536];
+		int detLength = ExpansionSum(abDet, abDetLength, cDet, cDetLength, det);
+
+		return det[detLength - 1];
 	}
 
-	// Point in line segment
-	bool PointInLineSegment(const glm::vec3& p, const glm::vec3& v1, const glm::vec3& v2)
+	// In circle test of the point d against the triangle (a, b, c) in the xz plane. When (a, b, c) is counter-clockwise
+	// the result is > 0 if d lies inside the circumcircle, < 0 if it lies outside and 0 if it lies on it.
+	// Adaptive: a floating point filter decides most cases and only the uncertain ones are computed exactly
+	double InCircle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d)
 	{
-		/*
+		double adx = (double)a.x - d.x;
+		double bdx = (double)b.x - d.x;
+		double cdx = (double)c.x - d.x;
+		double adz = (double)a.z - d.z;
+		double bdz = (double)b.z - d.z;
+		double cdz = (double)c.z - d.z;
+
+		double bdxcdz = bdx * cdz;
+		double cdxbdz = cdx * bdz;
+		double aLift = adx * adx + adz * adz;
 
-		P = S + v * t
+		double cdxadz = cdx * adz;
+		double adxcdz = adx * cdz;
+		double bLift = bdx * bdx + bdz * bdz;
 
-		t = (Px - Sx) / v1
-		t = (Py - Sy) / v2
+		double adxbdz = adx * bdz;
+		double bdxadz = bdx * adz;
+		double cLift = cdx * cdx + cdz * cdz;
 
-		point in segment if ---->  0 <= t <= 1
-		*/
+		double det = aLift * (bdxcdz - cdxbdz) + bLift * (cdxadz - adxcdz) + cLift * (adxbdz - bdxadz);
 
-		float distanceToLine = SqrDistanceFromPointToLine(p, v1, v2);
-		if (distanceToLine != 0)
+		double permanent = (std::abs(bdxcdz) + std::abs(cdxbdz)) * aLift
+						 + (std::abs(cdxadz) + std::abs(adxcdz)) * bLift
+						 + (std::abs(adxbdz) + std::abs(bdxadz)) * cLift;
+
+		double errorBound = Geom2DExact::INCIRCLE_ERROR_BOUND * permanent;
+		if (det > errorBound || -det > errorBound)
 		{
-			return false;
+			return det;
 		}
 
-		glm::vec3 v = (v2 - v1);
+		return InCircleExact(a, b, c, d);
+	}
 
-		float t0, t1;
+	// Exact orientation of the triangle (a, b, c) in the xz plane for points on an integer lattice: their coordinates times
+	// the scale are integers below 2^29 in magnitude (> 0 counter-clockwise, < 0 clockwise, 0 collinear)
+	double Orient2DInteger(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, float scale)
+	{
+		using namespace Geom2DInteger;
 
-		if (v.x == 0)
-		{
-			t1 = (p.z - v1.z) / v.z;
+		int64_t acx = LatticeCoordinate(a.x, scale) - LatticeCoordinate(c.x, scale);
+		int64_t acz = LatticeCoordinate(a.z, scale) - LatticeCoordinate(c.z, scale);
+		int64_t bcx = LatticeCoordinate(b.x, scale) - LatticeCoordinate(c.x, scale);
+		int64_t bcz = LatticeCoordinate(b.z, scale) - LatticeCoordinate(c.z, scale);
 
-			if (t1 >= 0 && t1 <= 1 && p.x == v1.x)
-			{
-				return true;
-			}
-		}
-		else if (v.z == 0)
-		{
-			t0 = (p.x - v1.x) / v.x;
+		return (double)(acx * bcz - acz * bcx);
+	}
 
-			if (t0 >= 0 && t0 <= 1 && p.z == v1.z)
-			{
-				return true;
-			}
-		}
-		else
-		{
-			t0 = (p.x - v1.x) / v.x;
-			t1 = (p.z - v1.z) / v.z;
+	// Exact in circle test of the point d against the triangle (a, b, c) in the xz plane for points on an integer lattice
+	// (see Orient2DInteger). When (a, b, c) is counter-clockwise the result is 1 if d lies inside the circumcircle, -1 if
+	// it lies outside and 0 if it lies on it
+	double InCircleInteger(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d, float scale)
+	{
+		using namespace Geom2DInteger;
 
-			if (t0 == t1 && t0 >= 0 && t0 <= 1)
-			{
-				return true;
-			}
+		int64_t dx = LatticeCoordinate(d.x, scale);
+		int64_t dz = LatticeCoordinate(d.z, scale);
+
+		int64_t adx = LatticeCoordinate(a.x, scale) - dx;
+		int64_t adz = LatticeCoordinate(a.z, scale) - dz;
+		int64_t bdx = LatticeCoordinate(b.x, scale) - dx;
+		int64_t bdz = LatticeCoordinate(b.z, scale) - dz;
+		int64_t cdx = LatticeCoordinate(c.x, scale) - dx;
+		int64_t cdz = LatticeCoordinate(c.z, scale) - dz;
+
+		Int128 det = Multiply(adx * adx + adz * adz, bdx * cdz - cdx * bdz);
+		det = Add(det, Multiply(bdx * bdx + bdz * bdz, cdx * adz - adx * cdz));
+		det = Add(det, Multiply(cdx * cdx + cdz * cdz, adx * bdz - bdx * adz));
+
+		return (double)Sign(det);
+	}
+
+	// Point in circle
+	bool PointInCircle(const glm::vec3& p, const glm::vec3& c, float r)
+	{
+		float x = p.x - c.x;
+		float z = p.z - c.z;
+
+		return (x*x + z*z <= r * r);
+	}
+
+	// Point in triangle (the boundary counts as inside, either winding)
+	bool PointInTriangle(const glm::vec3& p, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& v3)
+	{
+		double side1 = Orient2D(v1, v2, p);
+		double side2 = Orient2D(v2, v3, p);
+		double side3 = Orient2D(v3, v1, p);
+
+		bool hasNegative = side1 < 0.0 || side2 < 0.0 || side3 < 0.0;
+		bool hasPositive = side1 > 0.0 || side2 > 0.0 || side3 > 0.0;
+
+		return !(hasNegative && hasPositive);
+	}
+
+	// Point in line segment (end points included)
+	bool PointInLineSegment(const glm::vec3& p, const glm::vec3& v1, const glm::vec3& v2)
+	{
+		if (Orient2D(v1, v2, p) != 0.0)
+		{
+			return false;
 		}
 
-		return false;
+		// collinear, so it is enough to check the bounding box of the segment
+		return	p.x >= std::min(v1.x, v2.x) && p.x <= std::max(v1.x, v2.x)
+			&&	p.z >= std::min(v1.z, v2.z) && p.z <= std::max(v1.z, v2.z);
 	}
 
 	// Lines intersect
@@ -139,30 +303,25 @@ namespace Geom2DTest
 		return true;
 	}
 
-	// Triangle circuncemter
+	// Triangle circumcenter (in double precision, relative to the first vertex, as the lines through the middle points lose
+	// too much of it). The center of a degenerate triangle is not finite
 	void TriangleCircumcenter(const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& v3, glm::vec3& c, float& r)
 	{
-		// general equation line for two segments
-		float A1, B1, C1;
-		GetLine(v1, v2, A1, B1, C1);
-
-		float A2, B2, C2;
-		GetLine(v2, v3, A2, B2, C2);
-
-		// middle points of two segments
-		glm::vec3 segmentV1V2MiddlePoint = (0.5f * (v1 + v2));
-		glm::vec3 segmentV2V3MiddlePoint = (0.5f * (v2 + v3));
+		double bx = (double)v2.x - v1.x;
+		double bz = (double)v2.z - v1.z;
+		double cx = (double)v3.x - v1.x;
+		double cz = (double)v3.z - v1.z;
 
-		// perpendicular lines of two segments
-		float PA1, PB1, PC1;
-		GetPerpendicularToLineThroughPoint(A1, B1, C1, segmentV1V2MiddlePoint, PA1, PB1, PC1);
+		double b2 = bx * bx + bz * bz;
+		double c2 = cx * cx + cz * cz;
+		double d = 2.0 * (bx * cz - bz * cx);
 
-		float PA2, PB2, PC2;
-		GetPerpendicularToLineThroughPoint(A2, B2, C2, segmentV2V3MiddlePoint, PA2, PB2, PC2);
+		double x = (cz * b2 - bz * c2) / d;
+		double z = (bx * c2 - cx * b2) / d;
 
-		// circumcenter
-		LinesIntersects(PA1, PB1, PC1, PA2, PB2, PC2, c);
-		r = glm::distance(glm::vec2(c.x, c.z), glm::vec2(v3.x, v3.z));
+		c.x = (float)(v1.x + x);
+		c.z = (float)(v1.z + z);
+		r = (float)std::sqrt(x * x + z * z);
 	}
 }
 
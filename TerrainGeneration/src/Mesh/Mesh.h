@@ -105,6 +105,21 @@ public:
 		return true;
 	}
 
+	// Load mesh from vertices and triangle indices
+	bool Load(const std::vector<MeshVertex>& meshVertices, const std::vector<GLuint>& meshIndices)
+	{
+		// clear current mesh
+		Clear();
+
+		vertices = meshVertices;
+		indices = meshIndices;
+
+		// init buffers
+		InitBuffers();
+
+		return true;
+	}
+
 	// Draw
 	void Draw(const glm::mat4& viewProjection, Shader& shader)
 	{
@@ -0,0 +1,326 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Parallel
+{
+	// Number of worker threads to use
+	size_t NumThreads()
+	{
+		size_t numThreads = std::thread::hardware_concurrency();
+		return numThreads > 0 ? numThreads : 1;
+	}
+
+	// Pool of worker threads started once and reused by every parallel call (one thread less than NumThreads, since the
+	// calling thread always takes a share of the work). A thread waiting for its tasks takes back the ones nobody started
+	// and runs other queued tasks meanwhile, so nested parallel calls never leave the pool waiting on itself
+	class ThreadPool
+	{
+	public:
+
+		struct Task
+		{
+			std::function<void()> function;
+			bool done = false;
+		};
+
+		// Pool shared by the whole program
+		static ThreadPool& Get()
+		{
+			static ThreadPool pool(NumThreads() - 1);
+			return pool;
+		}
+
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stop = true;
+			}
+			taskAdded.notify_all();
+
+			for (auto& worker : workers)
+			{
+				worker.join();
+			}
+		}
+
+		// Queue the task (it has to outlive the call to Wait)
+		void Run(Task& task)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				tasks.push_back(&task);
+			}
+			taskAdded.notify_one();
+		}
+
+		// Wait for the task, running it in the calling thread if no worker has started it yet
+		void Wait(Task& task)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while (!task.done)
+			{
+				auto queued = std::find(tasks.begin(), tasks.end(), &task);
+				Task* next = queued != tasks.end() ? *queued : (tasks.empty() ? nullptr : tasks.front());
+				if (!next)
+				{
+					taskDone.wait(lock);
+					continue;
+				}
+
+				tasks.erase(queued != tasks.end() ? queued : tasks.begin());
+				Execute(*next, lock);
+			}
+		}
+
+	private:
+
+		std::vector<std::thread> workers;
+		std::deque<Task*> tasks;
+		std::mutex mutex;
+		std::condition_variable taskAdded;
+		std::condition_variable taskDone;
+		bool stop = false;
+
+		ThreadPool(size_t numWorkers)
+		{
+			workers.reserve(numWorkers);
+			for (size_t i = 0; i < numWorkers; i++)
+			{
+				workers.emplace_back([this]() { Work(); });
+			}
+		}
+
+		// Run the tasks queued until the pool stops
+		void Work()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			for (;;)
+			{
+				taskAdded.wait(lock, [this]() { return stop || !tasks.empty(); });
+				if (stop)
+				{
+					return;
+				}
+
+				Task* task = tasks.front();
+				tasks.pop_front();
+				Execute(*task, lock);
+			}
+		}
+
+		// Run a task taken from the queue without holding the lock
+		void Execute(Task& task, std::unique_lock<std::mutex>& lock)
+		{
+			lock.unlock();
+			task.function();
+			lock.lock();
+
+			task.done = true;
+			taskDone.notify_all();
+		}
+	};
+
+	// Split [begin, end) in contiguous blocks and run function(blockBegin, blockEnd, blockIndex) for each block in the
+	// thread pool. Ranges smaller than minBlockSize are run in the calling thread
+	template<typename Function>
+	size_t ForBlocks(size_t begin, size_t end, size_t minBlockSize, Function function)
+	{
+		size_t count = end > begin ? end - begin : 0;
+		size_t numBlocks = std::min(NumThreads(), std::max<size_t>(1, count / std::max<size_t>(1, minBlockSize)));
+
+		if (numBlocks <= 1)
+		{
+			function(begin, end, 0);
+			return 1;
+		}
+
+		size_t blockSize = (count + numBlocks - 1) / numBlocks;
+
+		ThreadPool& pool = ThreadPool::Get();
+		std::vector<ThreadPool::Task> tasks(numBlocks - 1);
+		for (size_t block = 1; block < numBlocks; block++)
+		{
+			size_t blockBegin = std::min(end, begin + block * blockSize);
+			size_t blockEnd = std::min(end, blockBegin + blockSize);
+			tasks[block - 1].function = [&function, blockBegin, blockEnd, block]() { function(blockBegin, blockEnd, block); };
+			pool.Run(tasks[block - 1]);
+		}
+
+		// the calling thread takes the first block
+		function(begin, std::min(end, begin + blockSize), 0);
+
+		for (auto& task : tasks)
+		{
+			pool.Wait(task);
+		}
+
+		return numBlocks;
+	}
+
+	// Run function(i) for every i in [begin, end)
+	template<typename Function>
+	void For(size_t begin, size_t end, size_t minBlockSize, Function function)
+	{
+		ForBlocks(begin, end, minBlockSize, [&function](size_t blockBegin, size_t blockEnd, size_t)
+		{
+			for (size_t i = blockBegin; i < blockEnd; i++)
+			{
+				function(i);
+			}
+		});
+	}
+
+	// Compact [0, count): call assign(i, index) for every i that passes keep(i), with index its position among the ones
+	// that pass. Each block counts its items, an exclusive prefix sum over the counts gives the first index of every block
+	// and then each block numbers its items. Returns the number of items that pass
+	template<typename Keep, typename Assign>
+	size_t Compact(size_t count, size_t minBlockSize, Keep keep, Assign assign)
+	{
+		std::vector<uint8_t> kept(count);
+		std::vector<size_t> offsets(NumThreads(), 0);
+
+		// both passes get the same blocks
+		size_t numBlocks = ForBlocks(0, count, minBlockSize, [&](size_t blockBegin, size_t blockEnd, size_t block)
+		{
+			size_t blockCount = 0;
+			for (size_t i = blockBegin; i < blockEnd; i++)
+			{
+				kept[i] = keep(i) ? 1 : 0;
+				blockCount += kept[i];
+			}
+			offsets[block] = blockCount;
+		});
+
+		size_t sum = 0;
+		for (size_t block = 0; block < numBlocks; block++)
+		{
+			size_t blockCount = offsets[block];
+			offsets[block] = sum;
+			sum += blockCount;
+		}
+
+		ForBlocks(0, count, minBlockSize, [&](size_t blockBegin, size_t blockEnd, size_t block)
+		{
+			size_t index = offsets[block];
+			for (size_t i = blockBegin; i < blockEnd; i++)
+			{
+				if (kept[i])
+				{
+					assign(i, index++);
+				}
+			}
+		});
+
+		return sum;
+	}
+
+	// Run two functions concurrently (the first one in the thread pool and the second one in the calling thread)
+	template<typename FunctionA, typename FunctionB>
+	void Invoke(FunctionA functionA, FunctionB functionB)
+	{
+		ThreadPool& pool = ThreadPool::Get();
+
+		ThreadPool::Task task;
+		task.function = functionA;
+		pool.Run(task);
+
+		functionB();
+
+		pool.Wait(task);
+	}
+
+	// Back off before retrying an operation that found its data taken by another thread (longer after every attempt)
+	void BackOff(int attempt)
+	{
+		int numYields = 1 << std::min(attempt, 10);
+		for (int i = 0; i < numYields; i++)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// Stable LSD radix sort of 64-bit items by their upper 32 bits (the lower 32 bits are a payload, usually an index)
+	void RadixSortByKey(uint64_t* items, size_t numItems)
+	{
+		const size_t RADIX_BITS = 8;
+		const size_t NUM_BUCKETS = 1 << RADIX_BITS;
+		const size_t MIN_BLOCK_SIZE = 1 << 16;
+		const size_t MIN_RADIX_SIZE = 1 << 10;
+
+		if (numItems < MIN_RADIX_SIZE)
+		{
+			// not worth the histogram passes
+			std::stable_sort(items, items + numItems, [](uint64_t a, uint64_t b) { return (a >> 32) < (b >> 32); });
+			return;
+		}
+
+		std::vector<uint64_t> scratchBuffer(numItems);
+		uint64_t* scratch = &scratchBuffer[0];
+
+		size_t numBlocks = std::min(NumThreads(), std::max<size_t>(1, numItems / MIN_BLOCK_SIZE));
+		size_t blockSize = (numItems + numBlocks - 1) / numBlocks;
+
+		// histogram per block and bucket
+		std::vector<size_t> offsets(numBlocks * NUM_BUCKETS);
+
+		for (size_t shift = 32; shift < 64; shift += RADIX_BITS)
+		{
+			std::fill(offsets.begin(), offsets.end(), 0);
+
+			ForBlocks(0, numBlocks, 1, [&](size_t firstBlock, size_t lastBlock, size_t)
+			{
+				for (size_t block = firstBlock; block < lastBlock; block++)
+				{
+					size_t* histogram = &offsets[block * NUM_BUCKETS];
+					size_t end = std::min(numItems, (block + 1) * blockSize);
+					for (size_t i = block * blockSize; i < end; i++)
+					{
+						histogram[(items[i] >> shift) & (NUM_BUCKETS - 1)]++;
+					}
+				}
+			});
+
+			// exclusive prefix sum in (bucket, block) order keeps the sort stable
+			size_t sum = 0;
+			for (size_t bucket = 0; bucket < NUM_BUCKETS; bucket++)
+			{
+				for (size_t block = 0; block < numBlocks; block++)
+				{
+					size_t count = offsets[block * NUM_BUCKETS + bucket];
+					offsets[block * NUM_BUCKETS + bucket] = sum;
+					sum += count;
+				}
+			}
+
+			ForBlocks(0, numBlocks, 1, [&](size_t firstBlock, size_t lastBlock, size_t)
+			{
+				for (size_t block = firstBlock; block < lastBlock; block++)
+				{
+					size_t* offset = &offsets[block * NUM_BUCKETS];
+					size_t end = std::min(numItems, (block + 1) * blockSize);
+					for (size_t i = block * blockSize; i < end; i++)
+					{
+						scratch[offset[(items[i] >> shift) & (NUM_BUCKETS - 1)]++] = items[i];
+					}
+				}
+			});
+
+			std::swap(items, scratch);
+		}
+
+		// an even number of passes leaves the result back in the caller's buffer
+		static_assert((64 - 32) / RADIX_BITS % 2 == 0, "odd number of radix passes");
+	}
+}
+
+#endif // !PARALLEL_H
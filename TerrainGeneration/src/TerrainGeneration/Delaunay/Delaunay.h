@@ -3,10 +3,41 @@
 
 #include "../../src/Geom2DTest/Geom2DTest.h"
 #include "../PointCloud/PointCloud.h"
+#include "DelaunayDivideAndConquer.h"
+#include "DelaunayEngine.h"
+#include "DelaunayInsertionOrder.h"
+#include "DelaunayMesh.h"
+#include "DelaunayPool.h"
+#include "DelaunayQuery.h"
+#include "DelaunaySnapshot.h"
+#include "DelaunayStats.h"
 #include "DelaunayStructures.h"
+#include "DelaunaySweepHull.h"
 #include "DelaunayTriangulationExporter.h"
-
+#include "DelaunayVoronoi.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
 #include <memory>
+#include <numeric>
+
+enum class DelaunayAlgorithm
+{
+	INCREMENTAL,			// insert the points one by one (the only one that can triangulate by iterations)
+	PARALLEL_INCREMENTAL,	// insert the points in batches, several at a time from worker threads (needs WALK point location)
+	DIVIDE_AND_CONQUER,		// triangulate the halves of the point cloud in parallel and merge them
+	SWEEP_HULL				// add the points by distance to the center, growing the convex hull (the fastest on a single thread)
+};
+
+enum class DelaunayPointLocation
+{
+	WALK,			// walk across the twin edges starting from the most recently created triangle
+	HISTORY_DAG		// descend the history DAG starting from the root triangle
+};
 
 class Delaunay
 {
@@ -16,66 +47,226 @@ class Delaunay
 	// root triangle
 	DelaunayTriangle* rootTriangle = nullptr;
 
+	// root triangle vertices (treated as if they were infinitely far away by the in circle test)
+	DelaunayVertex* rootVertices[3] = { nullptr, nullptr, nullptr };
+
+	// most recently created triangle (start of the walk)
+	DelaunayTriangle* lastTriangle = nullptr;
+
+	// work stack of the edges pending legalization
+	std::vector<DelaunayEdge*> edgesToLegalize;
+
+	// algorithm used by Triangulate
+	DelaunayAlgorithm algorithm = DelaunayAlgorithm::INCREMENTAL;
+
+	// one shot triangulation engines
+	DelaunayDivideAndConquer divideAndConquer;
+	DelaunaySweepHull sweepHull;
+
+	// point location strategy
+	DelaunayPointLocation pointLocation = DelaunayPointLocation::WALK;
+
+	// insertion order of the points
+	DelaunayInsertionOrder insertionOrder = DelaunayInsertionOrder::AS_GIVEN;
+	std::vector<uint32_t> insertionIndices;
+
+	// integer coordinates: the points are snapped to a lattice over their bounding box, whose step is a power of 2 (so the
+	// snapped coordinates stay exact as floats), and the predicates of the insertion are computed exactly with integers.
+	// The scale of the lattice is the inverse of its step (0 while the coordinates are not snapped)
+	bool integerCoordinates = false;
+	float latticeScale = 0.0f;
+
+	// State of a worker thread of the parallel insertion
+	struct ParallelInsertionWorker
+	{
+		// start of the walk
+		DelaunayTriangle* lastTriangle = nullptr;
+
+		// triangles locked by the worker: the cavity of the point and the triangles around it
+		std::vector<DelaunayTriangle*> cavity;
+		std::vector<DelaunayTriangle*> ring;
+
+		// edges of the cavity boundary (with their end vertices) and the objects to build the new triangles from
+		std::vector<DelaunayEdge*> boundary;
+		std::vector<DelaunayVertex*> boundaryEnds;
+		std::vector<DelaunayEdge*> spareEdges;
+		std::vector<DelaunayTriangle*> spareTriangles;
+
+		// statistics of the worker, added to the ones of the triangulation at the end
+		DelaunayStats stats;
+	};
+
+	enum class ParallelInsertionResult
+	{
+		INSERTED,
+		SKIPPED,	// duplicated point
+		CONFLICT	// a triangle was locked by another worker
+	};
+
+	// locks of the triangles during the parallel insertion, by the lock slot of the triangles (held by the worker that is
+	// changing the triangle or reading it)
+	std::vector< std::atomic<bool> > triangleLocks;
+
+	// statistics of the triangulation (the peaks of the pools are taken when they are asked for)
+	DelaunayStats stats;
+
 	// pool of triangles
-	size_t MAX_TRIANGLES = 1000000;
-	std::vector<DelaunayTriangle> trianglesPool;
+	DelaunayPool<DelaunayTriangle> trianglesPool;
 
 	// pool of edges
-	size_t MAX_EDGES = MAX_TRIANGLES * 6;
-	std::vector<DelaunayEdge> edgesPool;
+	DelaunayPool<DelaunayEdge> edgesPool;
 
 	// pool of vertices
-	size_t MAX_VERTICES = MAX_TRIANGLES * 3;
-	std::vector<DelaunayVertex> verticesPool;
+	DelaunayPool<DelaunayVertex> verticesPool;
 
-	// for tracking pool usage
-	size_t numDelaunayTriangleUsed = 0;
-	size_t numDelaunayEdgeUsed = 0;
-	size_t numDelaunayVertexUsed = 0;
+	// triangulation as a compact index based mesh, and the triangle and vertex behind every triangle and vertex of the mesh
+	DelaunayMesh triangulationMesh;
+	std::vector<DelaunayTriangle*> meshTriangles;
+	std::vector<DelaunayVertex*> meshVertices;
 
-	// triangulation
-	std::vector<DelaunayTriangle*> triangulation;
+	// triangles created, split or flipped by Insert and Remove (only collected while they change the triangulation)
+	std::vector<DelaunayTriangle*> touchedTriangles;
+	bool trackTouchedTriangles = false;
+
+	// polygon left by the vertex being removed: its vertices and the edges from each of them to the next one
+	std::vector<DelaunayVertex*> holeVertices;
+	std::vector<DelaunayEdge*> holeEdges;
+
+	// triangles around the vertex being removed, and the ones left over
+	std::vector<DelaunayTriangle*> holeTriangles;
+	std::vector<DelaunayTriangle*> releasedTriangles;
+
+	// polygons at both sides of the breakline segment being inserted (vertices and the edges from each of them to the next
+	// one, from the start of the segment to its end)
+	std::vector<DelaunayVertex*> polygonVertices[2];
+	std::vector<DelaunayEdge*> polygonEdges[2];
+
+	// Triangle to refine, by its quality (the squared ratio of its circumradius to its shortest edge, the larger the worse)
+	struct RefinementTriangle
+	{
+		double quality;
+		DelaunayTriangle* triangle;
+
+		bool operator<(const RefinementTriangle& other) const { return quality < other.quality; }
+	};
+
+	// Segment to split (a breakline or convex hull edge) with its end vertices, to tell whether it is still there
+	struct RefinementSegment
+	{
+		DelaunayEdge* edge;
+		DelaunayVertex* vertexA;
+		DelaunayVertex* vertexB;
+	};
+
+	// refinement: heap of the bad triangles (worst first), segments to split and the triangles whose circumcircle holds the
+	// Steiner point being added, with the bounds of the triangles (squared circumradius to shortest edge ratio, area and
+	// squared shortest edge refined)
+	std::vector<RefinementTriangle> badTriangles;
+	std::vector<RefinementSegment> encroachedSegments;
+	std::vector<DelaunayTriangle*> refinementCavity;
+	double refinementMaxQuality = 0.0;
+	double refinementMaxArea = 0.0;
+	double refinementMinLength = 0.0;
+
+	// the edges with root vertices are not flipped, so the convex hull keeps its edges (while refining, as its edges are
+	// split at midpoints that can fall a bit off them in floating point)
+	bool keepConvexHull = false;
+
+	// streaming: grid of cells over the bounds of the points (and the size of a cell), the cells finalized (no more points
+	// come in them), the triangles waiting in every cell (the ones whose circumcircle overlaps it, some of them stale) and
+	// the vertices written out that some triangle may still use
+	bool streaming = false;
+	glm::vec3 streamTopLeft;
+	glm::vec3 streamBottomRight;
+	double streamCellSizeX = 0.0;
+	double streamCellSizeZ = 0.0;
+	uint32_t numStreamCellsX = 0;
+	uint32_t numStreamCellsZ = 0;
+	std::vector<uint8_t> finalizedCells;
+	std::vector< std::vector<DelaunayTriangle*> > cellTriangles;
+	std::vector<DelaunayVertex*> streamedVertices;
+	size_t numKeptStreamedVertices = 0;
+	uint32_t numStreamedVertices = 0;
 
 	// triangulation exporter
 	DelaunayTriangulationExporter exporter;
 
 public:
 
-	Delaunay() 
-	{
-		// initialize pools
-		trianglesPool.resize(MAX_TRIANGLES);
-		edgesPool.resize(MAX_EDGES);
-		verticesPool.resize(MAX_VERTICES);
-	}
+	Delaunay() {}
 	~Delaunay() {}
 
 	// Clear
 	void Clear()
 	{
-		for (auto& triangle : trianglesPool)
-		{
-			triangle.Clear();
-		}
+		triangulationMesh.Clear();
+		meshTriangles.clear();
+		meshVertices.clear();
+		insertionIndices.clear();
+
+		trianglesPool.Reset();
+		edgesPool.Reset();
+		verticesPool.Reset();
+		rootTriangle = nullptr;
+		rootVertices[0] = rootVertices[1] = rootVertices[2] = nullptr;
+		lastTriangle = nullptr;
+		iteration = -1;
+		latticeScale = 0.0f;
+		stats.Clear();
 
-		for (auto& edge: edgesPool)
-		{
-			edge.Clear();
-		}
+		streaming = false;
+		finalizedCells.clear();
+		cellTriangles.clear();
+		streamedVertices.clear();
+	}
+
+	// Release the memory held by the pools (the triangulation is cleared)
+	void ReleaseMemory()
+	{
+		Clear();
 
-		for (auto& vertices: verticesPool)
+		trianglesPool.Release();
+		edgesPool.Release();
+		verticesPool.Release();
+
+		meshTriangles.shrink_to_fit();
+		meshVertices.shrink_to_fit();
+		touchedTriangles.shrink_to_fit();
+		holeVertices.shrink_to_fit();
+		holeEdges.shrink_to_fit();
+		holeTriangles.shrink_to_fit();
+		releasedTriangles.shrink_to_fit();
+		for (int side = 0; side < 2; side++)
 		{
-			vertices.Clear();
+			polygonVertices[side].shrink_to_fit();
+			polygonEdges[side].shrink_to_fit();
 		}
+		badTriangles.shrink_to_fit();
+		encroachedSegments.shrink_to_fit();
+		refinementCavity.shrink_to_fit();
+		finalizedCells.shrink_to_fit();
+		cellTriangles.shrink_to_fit();
+		streamedVertices.shrink_to_fit();
+		insertionIndices.shrink_to_fit();
+		edgesToLegalize.shrink_to_fit();
+
+		divideAndConquer.ReleaseMemory();
+		sweepHull.ReleaseMemory();
+	}
 
-		triangulation.clear();
+	// Set algorithm (of Triangulate, the triangulation by iterations is always incremental)
+	void SetAlgorithm(DelaunayAlgorithm newAlgorithm) { algorithm = newAlgorithm; }
 
-		numDelaunayTriangleUsed = 0;
-		numDelaunayEdgeUsed = 0;
-		numDelaunayTriangleUsed = 0;
-		rootTriangle = nullptr;
-		iteration = -1;
-	}
+	// Set point location strategy
+	void SetPointLocation(DelaunayPointLocation strategy) { pointLocation = strategy; }
+
+	// Set insertion order
+	void SetInsertionOrder(DelaunayInsertionOrder order) { insertionOrder = order; }
+
+	// Set integer coordinates (from the next triangulation on): the x and z of the points are snapped to a lattice over
+	// their bounding box, and the predicates are computed exactly with integers instead of adaptive floating point, which
+	// is faster and gives the same triangulation on every machine
+	void SetIntegerCoordinates(bool enabled) { integerCoordinates = enabled; }
 
 	// Triangulate
 	void Triangulate(const PointCloud& pointCloud)
@@ -83,296 +274,2913 @@ public:
 		// clear current triangulation
 		Clear();
 
-		// determine root triangle
-		DetermineRootTriangle(pointCloud);
+		DelaunayEngine* engine = Engine();
+		if (engine && integerCoordinates)
+		{
+			// the engines get the points snapped to the lattice, where their exact predicates give the same result
+			glm::vec3 topLeft, bottomRight;
+			pointCloud.GetBoundingBox(topLeft, bottomRight);
+			DetermineLattice(topLeft, bottomRight);
 
-		// add points to triangulation
-		AddPointsToTriangulation(pointCloud);
+			std::vector<glm::vec3> points(pointCloud.Points().size());
+			Parallel::For(0, points.size(), s_parallelMinBlockSize, [this, &points, &pointCloud](size_t i)
+			{
+				points[i] = QuantizePosition(pointCloud.Points()[i]);
+			});
+
+			DELAUNAY_STATS_TIMER(stats.insertionTime);
+			engine->Triangulate(points, triangulationMesh);
+			return;
+		}
+
+		if (engine)
+		{
+			DELAUNAY_STATS_TIMER(stats.insertionTime);
+			engine->Triangulate(pointCloud.Points(), triangulationMesh);
+			return;
+		}
+
+		TriangulateIncrementally(pointCloud.Points());
 
 		// get final triangulation
-		GetFinalTriangulation(triangulation);
+		ReleaseAllSplitTriangles();
+		ExtractTriangulationMesh();
 	}
 
-	// Triangulate by iterations (step by step)
-	void TriangulateByIterations(const PointCloud& pointCloud)
+	// Insert points into the current triangulation, which is kept live instead of triangulated again from scratch.
+	//
+	// The mesh of the triangulation is updated in place: the triangles that leave the triangulation hand their slots to the
+	// ones that join it, and the new vertices and the rest of the new triangles go at the end. Returns the indices of the
+	// mesh triangles that changed (rewritten or added), so the buffers built from the mesh can be updated the same way.
+	//
+	// The root triangle plays the role of the ghost triangles: the points outside the convex hull but inside the root
+	// triangle grow the hull as any other insertion. The points outside the root triangle, or the first insertion after
+	// a one shot engine (which keeps no live triangulation), triangulate everything again and report every triangle
+	std::vector<uint32_t> Insert(const glm::vec3* points, size_t numPoints)
 	{
-		if (iteration == -1)
+		std::vector<uint32_t> changedTriangles;
+		if (numPoints == 0)
 		{
-			// Determine the root triangle in the first iteration
-			DetermineRootTriangle(pointCloud);
+			return changedTriangles;
 		}
-		else if (iteration < pointCloud.Points().size())
+
+		bool live = rootTriangle != nullptr;
+		for (size_t i = 0; live && i < numPoints; i++)
 		{
-			// add another point to the triangulation
-			AddPointToTriangulation(pointCloud.Points()[iteration]);
+			live = IsPointInsideRootTriangle(points[i]);
 		}
-		else if (iteration == pointCloud.Points().size())
+
+		if (!live)
 		{
-			// get final triangulation
-			GetFinalTriangulation(triangulation);
+			std::vector<glm::vec3> allPoints;
+			allPoints.reserve(triangulationMesh.NumVertices() + numPoints);
+			for (uint32_t vertex = 0; vertex < triangulationMesh.NumVertices(); vertex++)
+			{
+				allPoints.push_back(triangulationMesh.Position(vertex));
+			}
+			allPoints.insert(allPoints.end(), points, points + numPoints);
+
+			// the breaklines are inserted again
+			std::vector<glm::vec3> segments;
+			GetConstrainedSegments(segments);
+
+			Clear();
+			TriangulateIncrementally(allPoints);
+
+			for (size_t i = 0; i < segments.size(); i += 2)
+			{
+				InsertConstrainedSegment(FindVertex(segments[i]), FindVertex(segments[i + 1]));
+			}
+
+			ReleaseAllSplitTriangles();
+			ExtractTriangulationMesh();
+
+			changedTriangles.resize(triangulationMesh.NumTriangles());
+			std::iota(changedTriangles.begin(), changedTriangles.end(), 0);
+
+			return changedTriangles;
 		}
 
-		iteration++;
+		// the triangles created, split or flipped are collected while the points are added
+		touchedTriangles.clear();
+		trackTouchedTriangles = true;
 
-		//PrintDebugInfo();
+		{
+			DELAUNAY_STATS_TIMER(stats.insertionTime);
+			for (size_t i = 0; i < numPoints; i++)
+			{
+				AddPointToTriangulation(points[i]);
+			}
+		}
+
+		trackTouchedTriangles = false;
+
+		UpdateTriangulationMesh(changedTriangles);
+
+		// with the walk point location nothing needs the triangles split any more
+		if (pointLocation == DelaunayPointLocation::WALK)
+		{
+			ReleaseSplitTriangles();
+		}
+
+		return changedTriangles;
 	}
 
-	// export triangulation
-	void ExportTriangulation(std::string& filename)
+	std::vector<uint32_t> Insert(const std::vector<glm::vec3>& points)
 	{
-		exporter.Export(TriangulationExportFormat::WAVEFRONT_OBJ, triangulation, filename, true);
+		return Insert(points.data(), points.size());
 	}
 
-	// get mesh from triangulation
-	void GetMeshFromTriangulation(Mesh& mesh)
+	// Insert a breakline (a polyline whose segments have to be edges of the triangulation) into the triangulation, which is
+	// kept live. The points are inserted first, and then every segment is made an edge by replacing the triangles it
+	// crosses with the triangulations of the polygons at both sides of it (the triangulation stays Delaunay but for the
+	// constrained edges, which are never flipped). A segment is split at the vertices it goes through and where it
+	// crosses another breakline.
+	//
+	// The mesh of the triangulation is updated as with Insert, returning the indices of the mesh triangles that changed.
+	// Nothing is inserted with the history DAG point location (the DAG cannot follow the triangles replaced)
+	std::vector<uint32_t> InsertBreakline(const glm::vec3* points, size_t numPoints)
 	{
-		// export first to Wavefront format
-		exporter.Export(TriangulationExportFormat::WAVEFRONT_OBJ, triangulation, std::string("tempWavefront"), false);
+		std::vector<uint32_t> changedTriangles;
+		if (numPoints == 0 || pointLocation != DelaunayPointLocation::WALK)
+		{
+			return changedTriangles;
+		}
 
-		// load the mesh
-		mesh.LoadWavefrontObj(std::string("assets/Triangulations/tempWavefront.obj"));
+		changedTriangles = Insert(points, numPoints);
 
-		// remove temporal file
-		std::remove("assets/Triangulations/tempWavefront.obj");
+		touchedTriangles.clear();
+		trackTouchedTriangles = true;
 
-		// reset export indices
-		for (auto& vertices : verticesPool)
+		DelaunayVertex* previousVertex = FindVertex(points[0]);
+		for (size_t i = 1; i < numPoints; i++)
 		{
-			vertices.exportIndex = -1;
+			DelaunayVertex* vertex = FindVertex(points[i]);
+			if (previousVertex && vertex)
+			{
+				InsertConstrainedSegment(previousVertex, vertex);
+			}
+			previousVertex = vertex;
 		}
-	}
 
-	// getters
-	DelaunayTriangle* RootTriangle() const { return rootTriangle; }
-	const std::vector<DelaunayTriangle*>& Triangulation() const { return triangulation; }
+		trackTouchedTriangles = false;
 
-	// Expansion for the root triangle
-	static const float s_rootTriangleExpansion;
+		UpdateTriangulationMesh(changedTriangles);
+		ReleaseSplitTriangles();
 
-private:
+		std::sort(changedTriangles.begin(), changedTriangles.end());
+		changedTriangles.erase(std::unique(changedTriangles.begin(), changedTriangles.end()), changedTriangles.end());
 
-	// Get a new DelaunayTriangle from the pool
-	DelaunayTriangle* GetNewDelaunayTriangle()
+		return changedTriangles;
+	}
+
+	std::vector<uint32_t> InsertBreakline(const std::vector<glm::vec3>& points)
 	{
-		if (numDelaunayTriangleUsed >= MAX_TRIANGLES)
-		{
-			assert(false);
-			return nullptr;
-		}
-		
-		return &trianglesPool[numDelaunayTriangleUsed++];
+		return InsertBreakline(points.data(), points.size());
 	}
 
-	// Get a new DelaunayEdge from the pool
-	DelaunayEdge* GetNewDelaunayEdge()
+	// Remove the vertex (index of the mesh) from the triangulation, which is kept live. The triangles around the vertex are
+	// replaced by a triangulation of the polygon they form, built by clipping ears (the ones whose circumcircle holds no
+	// other vertex of the polygon first) and made Delaunay with flips. The objects released go back to the pools.
+	//
+	// The mesh of the triangulation is updated as with Insert, and the last vertex of the mesh takes the index of the one
+	// removed. Returns the indices of the mesh triangles that changed. Nothing is removed with the history DAG point
+	// location (the DAG cannot forget a vertex) or without a live triangulation. The breakline segments at the vertex are
+	// lost
+	std::vector<uint32_t> Remove(uint32_t vertex)
 	{
-		if (numDelaunayEdgeUsed >= MAX_EDGES)
+		std::vector<uint32_t> changedTriangles;
+		if (!rootTriangle || pointLocation != DelaunayPointLocation::WALK || vertex >= meshVertices.size())
 		{
-			assert(false);
-			return nullptr;
+			return changedTriangles;
 		}
 
-		return &edgesPool[numDelaunayEdgeUsed++];
-	}
+		touchedTriangles.clear();
+		trackTouchedTriangles = true;
 
-	// Get a new DelaunayVertex from the pool
-	DelaunayVertex* GetNewDelaunayVertex()
-	{
-		if (numDelaunayVertexUsed >= MAX_VERTICES)
+		RemoveVertexFromTriangulation(meshVertices[vertex]);
+
+		trackTouchedTriangles = false;
+
+		// the last vertex of the mesh fills the slot, so the triangles around it change too
+		DelaunayVertex* lastVertex = meshVertices.back();
+		if (lastVertex != meshVertices[vertex])
 		{
-			assert(false);
-			return nullptr;
+			lastVertex->exportIndex = vertex;
+			meshVertices[vertex] = lastVertex;
+			triangulationMesh.positions[vertex] = triangulationMesh.positions.back();
+			triangulationMesh.heights[vertex] = triangulationMesh.heights.back();
+
+			DelaunayEdge* edge = lastVertex->edge;
+			do
+			{
+				touchedTriangles.push_back(edge->face);
+				edge = edge->next->next->twin;
+			} while (edge != lastVertex->edge);
+		}
+
+		meshVertices.pop_back();
+		triangulationMesh.positions.pop_back();
+		triangulationMesh.heights.pop_back();
+
+		UpdateTriangulationMesh(changedTriangles);
+
+		// the triangles left over go back to the pool once the mesh has freed their slots
+		for (auto triangle : releasedTriangles)
+		{
+			trianglesPool.Free(triangle);
 		}
+		releasedTriangles.clear();
 
-		return &verticesPool[numDelaunayVertexUsed++];
+		return changedTriangles;
 	}
 
-	// Determine root triangle
-	void DetermineRootTriangle(const PointCloud& pointCloud)
+	// Refine the triangulation, which is kept live, into a quality mesh (Ruppert's algorithm). The bad triangles, the ones
+	// with an angle smaller than the minimum angle (in degrees) or an area larger than the maximum area (when positive),
+	// get a Steiner point at their circumcenter, worst first. The breaklines and the convex hull are kept as segments: a
+	// segment encroached by a vertex (which lies inside the circle whose diameter is the segment) is split at its
+	// midpoint, and a circumcenter that would encroach segments splits them instead of being added. The heights of the
+	// Steiner points are interpolated.
+	//
+	// The minimum angle is clamped to s_refinementMaxAngle, as the refinement may not end above it. The angles between
+	// segments smaller than the minimum are left as they are, and so are the triangles and segments shorter than
+	// s_refinementMinEdgeLength (relative to the largest coordinate): close to the precision of the coordinates their
+	// Steiner points are not accurate anymore, and segments that meet at small angles would be refined down to it. The
+	// mesh of the triangulation is updated as with Insert, returning the indices of the mesh triangles that changed
+	std::vector<uint32_t> Refine(float minAngle, float maxArea = 0.0f)
 	{
-		// get the bounding box of the point cloud
-		glm::vec3 topLeft;
-		glm::vec3 bottomRight;
-		pointCloud.GetBoundingBox(topLeft, bottomRight, s_rootTriangleExpansion);
+		std::vector<uint32_t> changedTriangles;
+		if (!rootTriangle)
+		{
+			return changedTriangles;
+		}
 
-		// calculate the super triangle that contains the bounding box
-		// The intersection points of the 3 lines that define the triangle will be the vertices of the triangle
+		// the circumradius to shortest edge ratio of a triangle is 1 / (2 sin(a)), where a is its smallest angle
+		double angle = glm::radians(std::min(minAngle, s_refinementMaxAngle));
+		refinementMaxQuality = (angle > 0.0) ? 1.0 / (4.0 * std::sin(angle) * std::sin(angle)) : std::numeric_limits<double>::max();
+		refinementMaxArea = maxArea;
 
-		// calculate the lines that forms the triangle
-		float A1, B1, C1;
-		Geom2DTest::GetLine(topLeft, glm::vec3(topLeft.x + 1.0f, 0.0f, topLeft.z - 1.0f), A1, B1, C1);
+		float maxCoordinate = 0.0f;
+		for (auto& position : triangulationMesh.positions)
+		{
+			maxCoordinate = std::max(maxCoordinate, std::max(std::abs(position.x), std::abs(position.y)));
+		}
+		refinementMinLength = (double)s_refinementMinEdgeLength * maxCoordinate;
+		refinementMinLength *= refinementMinLength;
 
-		float A2, B2, C2;
-		Geom2DTest::GetLine(glm::vec3(bottomRight.x, 0.0f, topLeft.z), glm::vec3(bottomRight.x - 1.0f, 0.0f, topLeft.z - 1.0f), A2, B2, C2);
+		touchedTriangles.clear();
+		trackTouchedTriangles = true;
+		keepConvexHull = true;
 
-		float A3, B3, C3;
-		Geom2DTest::GetLine(glm::vec3(topLeft.x, 0.0f, bottomRight.z), bottomRight, A3, B3, C3);
+		RefineTriangulation();
 
-		// calculate triangle vertices
-		glm::vec3 v1, v2, v3;
-		Geom2DTest::LinesIntersects(A1, B1, C1, A2, B2, C2, v1);
-		Geom2DTest::LinesIntersects(A1, B1, C1, A3, B3, C3, v2);
-		Geom2DTest::LinesIntersects(A2, B2, C2, A3, B3, C3, v3);
+		keepConvexHull = false;
+		trackTouchedTriangles = false;
 
-		// set root triangle with adjacency information
-		rootTriangle = GetNewDelaunayTriangle();
-		rootTriangle->v1 = v1;
-		rootTriangle->v2 = v2;
-		rootTriangle->v3 = v3;
+		// a refinement that touched more triangles than the mesh has is cheaper to extract again
+		if (touchedTriangles.size() < meshTriangles.size())
+		{
+			UpdateTriangulationMesh(changedTriangles);
+		}
+		else
+		{
+			ExtractTriangulationMesh();
 
-		// set adjacency information
-		//
-		// get new half-edges
-		DelaunayEdge* edgeA = GetNewDelaunayEdge();
-		DelaunayEdge* edgeB = GetNewDelaunayEdge();
-		DelaunayEdge* edgeC = GetNewDelaunayEdge();
+			changedTriangles.resize(triangulationMesh.NumTriangles());
+			std::iota(changedTriangles.begin(), changedTriangles.end(), 0);
 
-		// root face edge
-		rootTriangle->edge = edgeA;
+			// each of them once, as the update leaves them
+			std::sort(touchedTriangles.begin(), touchedTriangles.end());
+			touchedTriangles.erase(std::unique(touchedTriangles.begin(), touchedTriangles.end()), touchedTriangles.end());
+		}
 
-		// root half-edge faces
-		edgeA->face = edgeB->face = edgeC->face = rootTriangle;
+		if (pointLocation == DelaunayPointLocation::WALK)
+		{
+			ReleaseSplitTriangles();
+		}
 
-		// root half-edge order
-		SetEdgesOrderRelationship(edgeA, edgeB, edgeC);
+		// the refinement rewrites large parts of the triangulation, so the live structure is checked as a whole (in debug)
+		assert(IsConsistent());
 
-		// root half-edge twins
-		SetEdgesTwinRelationship(edgeA, nullptr);
-		SetEdgesTwinRelationship(edgeB, nullptr);
-		SetEdgesTwinRelationship(edgeC, nullptr);
+		return changedTriangles;
+	}
 
-		// get new vertices
-		DelaunayVertex* vertexA = GetNewDelaunayVertex();
-		vertexA->v = v1;
-		vertexA->edge = edgeA;
+	// Begin a streamed triangulation, for point sets too large to be triangulated in memory. The bounds of the points are
+	// divided into a grid of cells, and the points come in chunks (StreamPoints) sorted so that the cells are completed one
+	// after another. Once no more points come in a cell it is finalized (FinalizeCell): the triangles whose circumcircle
+	// only overlaps finalized cells (or lies outside the bounds) will not change anymore, so they are written out through
+	// the exporter and their memory goes back to the pools, and so does the memory of the vertices that no triangle uses
+	// anymore. The memory in use stays bounded by the front of the triangles between the finalized cells and the rest.
+	//
+	// The triangulation is written to the file as it goes (Triangulation() stays empty), and the pools are taken over by
+	// the stream until EndStream. Nothing is streamed with the history DAG point location (the DAG cannot forget the
+	// triangles written out)
+	bool BeginStream(const glm::vec3& topLeft, const glm::vec3& bottomRight, uint32_t numCellsX, uint32_t numCellsZ, const std::string& filename)
+	{
+		if (pointLocation != DelaunayPointLocation::WALK || numCellsX == 0 || numCellsZ == 0)
+		{
+			return false;
+		}
 
-		DelaunayVertex* vertexB = GetNewDelaunayVertex();
-		vertexB->v = v2;
-		vertexB->edge = edgeB;
+		Clear();
 
-		DelaunayVertex* vertexC = GetNewDelaunayVertex();
-		vertexC->v = v3;
-		vertexC->edge = edgeC;
+		if (!exporter.BeginStream(TriangulationExportFormat::WAVEFRONT_OBJ, filename, true))
+		{
+			return false;
+		}
 
-		// hald-edge start vertex
-		SetEdgesVertexRelationship(edgeA, vertexA);
-		SetEdgesVertexRelationship(edgeB, vertexB);
-		SetEdgesVertexRelationship(edgeC, vertexC);
+		DetermineRootTriangle({ topLeft, bottomRight });
+
+		streaming = true;
+		streamTopLeft = topLeft;
+		streamBottomRight = bottomRight;
+
+		// a flat bounds still gets cells of some size
+		double sizeX = (double)bottomRight.x - topLeft.x;
+		double sizeZ = (double)bottomRight.z - topLeft.z;
+		streamCellSizeX = ((sizeX > 0.0) ? sizeX : 1.0) / numCellsX;
+		streamCellSizeZ = ((sizeZ > 0.0) ? sizeZ : 1.0) / numCellsZ;
+		numStreamCellsX = numCellsX;
+		numStreamCellsZ = numCellsZ;
+		finalizedCells.assign(numCellsX * numCellsZ, 0);
+		cellTriangles.resize(numCellsX * numCellsZ);
+		numKeptStreamedVertices = 0;
+		numStreamedVertices = 0;
+
+		return true;
 	}
 
-	// Add points to triangulation
-	void AddPointsToTriangulation(const PointCloud& pointCloud)
+	// Add a chunk of points to the streamed triangulation. The points outside the bounds or in finalized cells are skipped
+	void StreamPoints(const glm::vec3* points, size_t numPoints)
 	{
-		auto& points = pointCloud.Points();
-		for (auto& point : points)
+		if (!streaming)
+		{
+			return;
+		}
+
+		touchedTriangles.clear();
+		trackTouchedTriangles = true;
+
+		{
+			DELAUNAY_STATS_TIMER(stats.insertionTime);
+			for (size_t i = 0; i < numPoints; i++)
+			{
+				uint32_t cell;
+				if (GetStreamCell(points[i], cell) && !finalizedCells[cell])
+				{
+					AddPointToTriangulation(points[i]);
+				}
+			}
+		}
+
+		trackTouchedTriangles = false;
+
+		// each of them once, as the release expects
+		std::sort(touchedTriangles.begin(), touchedTriangles.end());
+		touchedTriangles.erase(std::unique(touchedTriangles.begin(), touchedTriangles.end()), touchedTriangles.end());
+
+		ReleaseSplitTriangles();
+
+		// the new (or flipped) triangles wait in a cell that their circumcircle overlaps, unless they are final already
+		for (auto triangle : touchedTriangles)
 		{
-			AddPointToTriangulation(point);
+			if (IsTriangulationTriangle(triangle))
+			{
+				QueueStreamTriangle(triangle);
+			}
 		}
+
+		ReleaseStreamedVertices();
 	}
 
-	// Add point to triangulation
-	void AddPointToTriangulation(const glm::vec3& point)
+	void StreamPoints(const std::vector<glm::vec3>& points)
 	{
-		// get the triangle in which the point lies
-		DelaunayTriangle* triangle = GetTriangleWhereToAddPoint(point, rootTriangle);
-		//assert(triangle);
-		if (!triangle)
+		StreamPoints(points.data(), points.size());
+	}
+
+	// Finalize the cell of the streamed triangulation (no more points come in it), writing out the triangles that are
+	// final now
+	void FinalizeCell(uint32_t cellX, uint32_t cellZ)
+	{
+		if (!streaming || cellX >= numStreamCellsX || cellZ >= numStreamCellsZ)
 		{
-			// no triangle found
 			return;
 		}
-		// check if the point lies in one of the edges of the triangle found
-		if (IsPointInTriangleEdge(triangle, point))
+
+		uint32_t cell = cellZ * numStreamCellsX + cellX;
+		if (finalizedCells[cell])
 		{
-			// split adjacent triangles
-			SplitAdjacentTriangles(triangle, point);
+			return;
 		}
-		else
+
+		finalizedCells[cell] = 1;
+
+		// the triangles waiting in the cell move to another cell their circumcircle overlaps, or are written out
+		std::vector<DelaunayTriangle*> triangles;
+		triangles.swap(cellTriangles[cell]);
+
+		for (auto triangle : triangles)
 		{
-			// split triangle
-			SplitTriangle(triangle, point);
+			if (IsTriangulationTriangle(triangle))
+			{
+				QueueStreamTriangle(triangle);
+			}
 		}
+
+		ReleaseStreamedVertices();
 	}
 
-	// Get Triangle where to add point
-	DelaunayTriangle* GetTriangleWhereToAddPoint(const glm::vec3& point, DelaunayTriangle* triangle)
-	{	
-		const glm::vec3& v1 = triangle->edge->v->v;
-		const glm::vec3& v2 = triangle->edge->next->v->v;
-		const glm::vec3& v3 = triangle->edge->next->next->v->v;
+	// End the streamed triangulation, writing out the triangles left and closing the file
+	void EndStream()
+	{
+		if (!streaming)
+		{
+			return;
+		}
 
-		// Point in triangle test to check the triangle that contains the point to be added
-		if (Geom2DTest::PointInTriangle(point, v1, v2, v3))
+		for (size_t i = 0; i < trianglesPool.NumUsed(); i++)
 		{
-			if (triangle->children.size() == 0)
+			DelaunayTriangle* triangle = &trianglesPool[i];
+			if (IsTriangulationTriangle(triangle))
 			{
-				// Leaf... so return this one
-				return triangle;
+				WriteStreamTriangle(triangle);
 			}
-			else
+		}
+
+		exporter.EndStream();
+
+		Clear();
+	}
+
+	// Triangulate by iterations (step by step)
+	void TriangulateByIterations(const PointCloud& pointCloud)
+	{
+		if (iteration == -1)
+		{
+			// Determine the root triangle and the insertion order in the first iteration
+			ReservePools(pointCloud.Points());
+			DetermineRootTriangle(pointCloud.Points());
+			DetermineInsertionOrder(pointCloud.Points());
+		}
+		else if (iteration < pointCloud.Points().size())
+		{
+			// add another point to the triangulation
+			AddPointToTriangulation(pointCloud.Points()[insertionIndices[iteration]]);
+		}
+		else if (iteration == pointCloud.Points().size())
+		{
+			// get final triangulation
+			ReleaseAllSplitTriangles();
+			ExtractTriangulationMesh();
+		}
+
+		iteration++;
+
+		//PrintDebugInfo();
+	}
+
+	// export triangulation
+	void ExportTriangulation(const std::string& filename)
+	{
+		exporter.Export(TriangulationExportFormat::WAVEFRONT_OBJ, triangulationMesh, filename, true);
+	}
+
+	// Save a snapshot of the triangulation to a binary file (see DelaunaySnapshot.h): its vertices and its half-edges as
+	// indices, with the whole live triangulation when there is one (the triangles of the root triangle included), so that
+	// LoadSnapshot gets it back without computing anything. The history DAG is not saved, and a triangulation by iterations
+	// is saved once its mesh is extracted. Returns false if the file cannot be written, or while streaming
+	bool SaveSnapshot(const std::string& filename)
+	{
+		if (streaming)
+		{
+			return false;
+		}
+
+		const size_t minBlockSize = 1 << 12;
+
+		// the vertices and the triangles of the live triangulation that are not in the mesh: the triangles around the
+		// vertices of the root triangle, found by adjacency, and their vertices. They go after the ones of the mesh,
+		// numbered through their export index while the snapshot is built
+		std::vector<DelaunayVertex*> outerVertices;
+		std::vector<DelaunayTriangle*> outerTriangles;
+		if (rootTriangle)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				AddSnapshotOuterTriangles(rootVertices[i], outerTriangles);
+			}
+
+			for (auto triangle : outerTriangles)
+			{
+				DelaunayEdge* edge = triangle->edge;
+				for (int j = 0; j < 3; j++, edge = edge->next)
+				{
+					if (edge->v->exportIndex < 0)
+					{
+						edge->v->exportIndex = (int)(triangulationMesh.NumVertices() + outerVertices.size());
+						outerVertices.push_back(edge->v);
+					}
+				}
+			}
+		}
+
+		auto forgetOuterIndices = [&outerVertices, &outerTriangles]()
+		{
+			for (auto vertex : outerVertices)
+			{
+				vertex->exportIndex = -1;
+			}
+
+			for (auto triangle : outerTriangles)
+			{
+				triangle->exportIndex = -1;
+			}
+		};
+
+		DelaunaySnapshotHeader header;
+		header.numMeshVertices = triangulationMesh.NumVertices();
+		header.numMeshTriangles = triangulationMesh.NumTriangles();
+		header.latticeScale = latticeScale;
+
+		size_t numVertices = header.numMeshVertices + outerVertices.size();
+		size_t numTriangles = header.numMeshTriangles + outerTriangles.size();
+		if (3 * numTriangles >= DelaunayMesh::INVALID_INDEX)
+		{
+			forgetOuterIndices();
+			return false;
+		}
+
+		header.numVertices = (uint32_t)numVertices;
+		header.numTriangles = (uint32_t)numTriangles;
+
+		if (rootTriangle)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				header.rootVertices[i] = rootVertices[i]->exportIndex;
+			}
+		}
+
+		std::unique_ptr<char[]> buffer(new char[header.FileSize()]);
+		std::memcpy(buffer.get(), &header, sizeof(header));
+
+		glm::vec3* positions = reinterpret_cast<glm::vec3*>(buffer.get() + header.PositionsOffset());
+		uint32_t* vertexEdges = reinterpret_cast<uint32_t*>(buffer.get() + header.VertexEdgesOffset());
+		uint32_t* origins = reinterpret_cast<uint32_t*>(buffer.get() + header.OriginsOffset());
+		uint32_t* twins = reinterpret_cast<uint32_t*>(buffer.get() + header.TwinsOffset());
+		uint8_t* constrained = reinterpret_cast<uint8_t*>(buffer.get() + header.ConstrainedOffset());
+
+		if (!rootTriangle)
+		{
+			// only the mesh (of a one shot engine), which has no half-edges of the vertices nor breaklines
+			Parallel::For(0, numVertices, minBlockSize, [this, positions, vertexEdges](size_t i)
+			{
+				positions[i] = triangulationMesh.Position((uint32_t)i);
+				vertexEdges[i] = DelaunayMesh::INVALID_INDEX;
+			});
+
+			std::copy(triangulationMesh.origins.begin(), triangulationMesh.origins.end(), origins);
+			std::copy(triangulationMesh.twins.begin(), triangulationMesh.twins.end(), twins);
+			std::fill(constrained, constrained + 3 * numTriangles, (uint8_t)0);
+		}
+		else
+		{
+			Parallel::For(0, numVertices, minBlockSize, [this, &header, &outerVertices, positions, vertexEdges](size_t i)
+			{
+				const DelaunayVertex* vertex = (i < header.numMeshVertices) ? meshVertices[i] : outerVertices[i - header.numMeshVertices];
+				positions[i] = vertex->v;
+				vertexEdges[i] = 3 * vertex->edge->face->exportIndex + EdgeSlot(vertex->edge);
+			});
+
+			Parallel::For(0, numTriangles, minBlockSize, [this, &header, &outerTriangles, origins, twins, constrained](size_t i)
+			{
+				const DelaunayTriangle* triangle = (i < header.numMeshTriangles) ? meshTriangles[i] : outerTriangles[i - header.numMeshTriangles];
+
+				const DelaunayEdge* edge = triangle->edge;
+				for (uint32_t j = 0; j < 3; j++, edge = edge->next)
+				{
+					size_t snapshotEdge = 3 * i + j;
+					const DelaunayEdge* twin = edge->twin;
+
+					origins[snapshotEdge] = edge->v->exportIndex;
+					twins[snapshotEdge] = twin ? 3 * twin->face->exportIndex + EdgeSlot(twin) : DelaunayMesh::INVALID_INDEX;
+					constrained[snapshotEdge] = edge->constrained ? 1 : 0;
+				}
+			});
+		}
+
+		forgetOuterIndices();
+
+		// a snapshot that LoadSnapshot would refuse is not written
+		if (!DelaunaySnapshot::IsValid(buffer.get(), header.FileSize()))
+		{
+			return false;
+		}
+
+		std::ofstream file(filename, std::ios::binary);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		file.write(buffer.get(), header.FileSize());
+
+		return file.good();
+	}
+
+	// Load a snapshot saved by SaveSnapshot, replacing the triangulation. The file is read at once and the pools and the
+	// mesh are filled straight from its arrays in parallel, so nothing is triangulated again: a live triangulation comes
+	// back live (Insert, InsertBreakline, Remove and Refine go on from it) and one without it comes back as its mesh. A
+	// live snapshot is not loaded with the history DAG point location (the DAG is not saved). Returns false, leaving the
+	// triangulation as it was, if the file cannot be read or is not a valid snapshot, or while streaming
+	bool LoadSnapshot(const std::string& filename)
+	{
+		if (streaming)
+		{
+			return false;
+		}
+
+		std::ifstream file(filename, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		size_t size = (size_t)file.tellg();
+		std::unique_ptr<char[]> buffer(new char[size]);
+
+		file.seekg(0);
+		if (!file.read(buffer.get(), size) || !DelaunaySnapshot::IsValid(buffer.get(), size))
+		{
+			return false;
+		}
+
+		const DelaunaySnapshotHeader& header = *reinterpret_cast<const DelaunaySnapshotHeader*>(buffer.get());
+		if (header.IsLive() && pointLocation != DelaunayPointLocation::WALK)
+		{
+			return false;
+		}
+
+		const glm::vec3* positions = reinterpret_cast<const glm::vec3*>(buffer.get() + header.PositionsOffset());
+		const uint32_t* vertexEdges = reinterpret_cast<const uint32_t*>(buffer.get() + header.VertexEdgesOffset());
+		const uint32_t* origins = reinterpret_cast<const uint32_t*>(buffer.get() + header.OriginsOffset());
+		const uint32_t* twins = reinterpret_cast<const uint32_t*>(buffer.get() + header.TwinsOffset());
+		const uint8_t* constrained = reinterpret_cast<const uint8_t*>(buffer.get() + header.ConstrainedOffset());
+
+		const size_t minBlockSize = 1 << 12;
+
+		Clear();
+		latticeScale = header.latticeScale;
+
+		triangulationMesh.positions.resize(header.numMeshVertices);
+		triangulationMesh.heights.resize(header.numMeshVertices);
+		triangulationMesh.origins.resize(3 * (size_t)header.numMeshTriangles);
+		triangulationMesh.twins.resize(3 * (size_t)header.numMeshTriangles);
+
+		if (!header.IsLive())
+		{
+			Parallel::For(0, header.numMeshVertices, minBlockSize, [this, positions](size_t i)
+			{
+				triangulationMesh.positions[i] = glm::vec2(positions[i].x, positions[i].z);
+				triangulationMesh.heights[i] = positions[i].y;
+			});
+
+			std::copy(origins, origins + triangulationMesh.origins.size(), triangulationMesh.origins.begin());
+			std::copy(twins, twins + triangulationMesh.twins.size(), triangulationMesh.twins.begin());
+			triangulationMesh.LinkTriangles();
+
+			return true;
+		}
+
+		// the pools are empty, so the objects of the snapshot take consecutive slots from their start
+		size_t firstVertex = verticesPool.GetNewRange(header.numVertices);
+		size_t firstTriangle = trianglesPool.GetNewRange(header.numTriangles);
+		size_t firstEdge = edgesPool.GetNewRange(3 * (size_t)header.numTriangles);
+
+		meshVertices.resize(header.numMeshVertices);
+		meshTriangles.resize(header.numMeshTriangles);
+
+		Parallel::For(0, header.numVertices, minBlockSize, [&](size_t i)
+		{
+			DelaunayVertex& vertex = verticesPool[firstVertex + i];
+			vertex.Clear();
+			vertex.v = positions[i];
+			vertex.edge = &edgesPool[firstEdge + vertexEdges[i]];
+
+			if (i < header.numMeshVertices)
+			{
+				vertex.exportIndex = (int)i;
+				meshVertices[i] = &vertex;
+				triangulationMesh.positions[i] = glm::vec2(vertex.v.x, vertex.v.z);
+				triangulationMesh.heights[i] = vertex.v.y;
+			}
+		});
+
+		uint32_t numMeshHalfEdges = 3 * header.numMeshTriangles;
+
+		Parallel::For(0, header.numTriangles, minBlockSize, [&](size_t i)
+		{
+			DelaunayTriangle& triangle = trianglesPool[firstTriangle + i];
+			triangle.Clear();
+			triangle.edge = &edgesPool[firstEdge + 3 * i];
+
+			// the edges of a triangle may straddle two chunks of the pool
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				size_t snapshotEdge = 3 * i + j;
+				DelaunayEdge& edge = edgesPool[firstEdge + snapshotEdge];
+				edge.twin = (twins[snapshotEdge] != DelaunayMesh::INVALID_INDEX) ? &edgesPool[firstEdge + twins[snapshotEdge]] : nullptr;
+				edge.next = &edgesPool[firstEdge + 3 * i + (j + 1) % 3];
+				edge.v = &verticesPool[firstVertex + origins[snapshotEdge]];
+				edge.face = &triangle;
+				edge.constrained = constrained[snapshotEdge] != 0;
+			}
+
+			// the mesh twins in the triangles of the root triangle are left unset
+			if (i < header.numMeshTriangles)
+			{
+				triangle.exportIndex = (int)i;
+				meshTriangles[i] = &triangle;
+
+				for (uint32_t j = 0; j < 3; j++)
+				{
+					size_t snapshotEdge = 3 * i + j;
+					triangulationMesh.origins[snapshotEdge] = origins[snapshotEdge];
+					triangulationMesh.twins[snapshotEdge] = (twins[snapshotEdge] < numMeshHalfEdges) ? twins[snapshotEdge] : DelaunayMesh::INVALID_INDEX;
+				}
+			}
+		});
+
+		triangulationMesh.LinkTriangles();
+
+		for (int i = 0; i < 3; i++)
+		{
+			rootVertices[i] = &verticesPool[firstVertex + header.rootVertices[i]];
+		}
+
+		// the root triangle is not part of the triangulation any more (only its vertices are), but it still tells that the
+		// triangulation is live
+		rootTriangle = GetNewDelaunayTriangle();
+
+		lastTriangle = &trianglesPool[firstTriangle];
+
+		return true;
+	}
+
+	// Get the Voronoi diagram of the triangulation (its dual), clipped to the box
+	void GetVoronoiDiagram(const glm::vec3& topLeft, const glm::vec3& bottomRight, DelaunayVoronoi& voronoi) const
+	{
+		voronoi.Build(triangulationMesh, topLeft, bottomRight);
+	}
+
+	// Query the triangulation at a batch of positions (x, z): the triangle that contains every position, its barycentric
+	// coordinates and the interpolated height. It only reads the triangulation, so it can be called from several threads
+	// at once while nothing modifies it
+	void Query(const glm::vec2* positions, size_t numPositions, DelaunayInterpolation interpolation, DelaunayQueryResult* results) const
+	{
+		DelaunayQuery::Query(triangulationMesh, positions, numPositions, interpolation, results);
+	}
+
+	// Query the triangulation at a batch of positions (x, z)
+	std::vector<DelaunayQueryResult> Query(const std::vector<glm::vec2>& positions, DelaunayInterpolation interpolation) const
+	{
+		std::vector<DelaunayQueryResult> results(positions.size());
+		Query(positions.data(), positions.size(), interpolation, results.data());
+
+		return results;
+	}
+
+	// get mesh from triangulation
+	void GetMeshFromTriangulation(Mesh& mesh)
+	{
+		std::vector<MeshVertex> vertices(triangulationMesh.NumVertices());
+		for (uint32_t vertex = 0; vertex < triangulationMesh.NumVertices(); vertex++)
+		{
+			vertices[vertex].pos = triangulationMesh.Position(vertex);
+		}
+
+		// the half-edge origins are the triangle indices
+		mesh.Load(vertices, triangulationMesh.origins);
+	}
+
+	// Statistics of the triangulation since it was last cleared (by Triangulate, for one), with the peak usage of the pools
+	DelaunayStats Stats() const
+	{
+		DelaunayStats current = stats;
+		current.peakTriangles = std::max(current.peakTriangles, trianglesPool.NumUsed());
+		current.peakEdges = std::max(current.peakEdges, edgesPool.NumUsed());
+		current.peakVertices = std::max(current.peakVertices, verticesPool.NumUsed());
+
+		return current;
+	}
+
+	// Is the live triangulation consistent (for debugging, as it visits the whole pools): the leaves of the triangulation
+	// are the triangles of the mesh at their export index, their half-edges make cycles whose twins match from both sides
+	// and every vertex of the mesh (or of the root triangle) starts a half-edge of a leaf. Without a live triangulation
+	// there is only the mesh
+	bool IsConsistent() const
+	{
+		if (!rootTriangle)
+		{
+			return true;
+		}
+
+		size_t numLeaves = 0;
+		for (size_t i = 0; i < trianglesPool.NumUsed(); i++)
+		{
+			const DelaunayTriangle* triangle = &trianglesPool[i];
+			if (!IsLiveTriangle(triangle))
+			{
+				continue;
+			}
+
+			const DelaunayEdge* edge = triangle->edge;
+			for (int j = 0; j < 3; j++, edge = edge->next)
+			{
+				const DelaunayEdge* twin = edge->twin;
+				if (edge->face != triangle || (twin && (twin->twin != edge || twin->v != edge->next->v || !IsLiveTriangle(twin->face))))
+				{
+					return false;
+				}
+			}
+
+			if (edge != triangle->edge)
+			{
+				return false;
+			}
+
+			if (IsTriangulationTriangle(triangle))
+			{
+				numLeaves++;
+				if (triangle->exportIndex < 0 || (size_t)triangle->exportIndex >= meshTriangles.size() || meshTriangles[triangle->exportIndex] != triangle)
+				{
+					return false;
+				}
+			}
+			else if (triangle->exportIndex >= 0)
+			{
+				return false;
+			}
+		}
+
+		for (size_t i = 0; i < meshVertices.size(); i++)
+		{
+			if (meshVertices[i]->exportIndex != (int)i || !IsLiveVertex(meshVertices[i]))
+			{
+				return false;
+			}
+		}
+
+		for (int i = 0; i < 3; i++)
+		{
+			if (!IsLiveVertex(rootVertices[i]))
+			{
+				return false;
+			}
+		}
+
+		return numLeaves == meshTriangles.size() && meshTriangles.size() == triangulationMesh.NumTriangles();
+	}
+
+	// Count the edges of the mesh that are not locally Delaunay: the vertex opposite to the edge in one of its triangles lies
+	// strictly inside the circumcircle of the other one (the breaklines aside, which are kept anyway). A verification
+	// pass over the whole mesh, whose edges are tested in chunks with the batched in circle test, in parallel
+	size_t CountIllegalEdges() const
+	{
+		const size_t minBlockSize = 1 << 12;
+		const size_t chunkSize = 256;
+
+		std::vector<size_t> counts(Parallel::NumThreads(), 0);
+
+		Parallel::ForBlocks(0, triangulationMesh.NumHalfEdges(), minBlockSize, [&](size_t blockBegin, size_t blockEnd, size_t block)
+		{
+			// x and z of the vertices of the triangle (counter-clockwise) and of the opposite vertex of every edge of the chunk
+			std::vector<float> coordinates(8 * chunkSize);
+			Geom2DBatch::Points points[4];
+			for (int i = 0; i < 4; i++)
+			{
+				points[i] = { &coordinates[2 * i * chunkSize], &coordinates[(2 * i + 1) * chunkSize] };
+			}
+
+			std::vector<double> inCircles(chunkSize);
+			size_t numEdges = 0;
+
+			auto testChunk = [&]()
+			{
+				Geom2DBatch::InCircle(points[0], points[1], points[2], points[3], numEdges, &inCircles[0]);
+				counts[block] += std::count_if(inCircles.begin(), inCircles.begin() + numEdges, [](double inCircle) { return inCircle > 0.0; });
+				numEdges = 0;
+			};
+
+			for (uint32_t edge = (uint32_t)blockBegin; edge < blockEnd; edge++)
+			{
+				// every shared edge once, from its lower half-edge
+				uint32_t twin = triangulationMesh.twins[edge];
+				if (twin == DelaunayMesh::INVALID_INDEX || twin < edge || IsConstrainedMeshEdge(edge))
+				{
+					continue;
+				}
+
+				// the triangles are clockwise, so (i, k, j) is the counter-clockwise order the in circle test expects
+				uint32_t next = triangulationMesh.nexts[edge];
+				uint32_t vertices[4] =
+				{
+					triangulationMesh.origins[edge],
+					triangulationMesh.origins[triangulationMesh.nexts[next]],
+					triangulationMesh.origins[next],
+					triangulationMesh.origins[triangulationMesh.nexts[triangulationMesh.nexts[twin]]]
+				};
+
+				for (int i = 0; i < 4; i++)
+				{
+					const glm::vec2& position = triangulationMesh.positions[vertices[i]];
+					coordinates[2 * i * chunkSize + numEdges] = position.x;
+					coordinates[(2 * i + 1) * chunkSize + numEdges] = position.y;
+				}
+
+				if (++numEdges == chunkSize)
+				{
+					testChunk();
+				}
+			}
+
+			testChunk();
+		});
+
+		return std::accumulate(counts.begin(), counts.end(), (size_t)0);
+	}
+
+	// getters
+	DelaunayTriangle* RootTriangle() const { return rootTriangle; }
+	const DelaunayMesh& Triangulation() const { return triangulationMesh; }
+
+	// Expansion for the root triangle, relative to the size of the point cloud
+	static const float s_rootTriangleExpansion;
+
+	// Points inserted one by one before the parallel insertion starts, and minimum points per worker
+	static const size_t s_parallelFirstBatchSize;
+	static const size_t s_parallelMinBlockSize;
+
+	// Largest minimum angle of the refinement (in degrees), and shortest edge refined (relative to the largest coordinate)
+	static const float s_refinementMaxAngle;
+	static const float s_refinementMinEdgeLength;
+
+	// Relative tolerance of the circumcircles that tell whether a triangle of the streamed triangulation is final
+	static const double s_streamCircleTolerance;
+
+	// Bits of the largest lattice coordinate (in magnitude) with integer coordinates, so that the exact orientation fits
+	// in 64-bit integers and the exact in circle test in 128-bit ones
+	static const int s_latticeBits;
+
+private:
+
+	// Engine of the algorithm (nullptr for the incremental one, which is implemented here)
+	DelaunayEngine* Engine()
+	{
+		switch (algorithm)
+		{
+		case DelaunayAlgorithm::DIVIDE_AND_CONQUER:
+			return &divideAndConquer;
+		case DelaunayAlgorithm::SWEEP_HULL:
+			return &sweepHull;
+		default:
+			return nullptr;
+		}
+	}
+
+	// Triangulate the points with the incremental algorithm (one by one or in parallel), leaving the triangulation live (the
+	// mesh is not extracted)
+	void TriangulateIncrementally(const std::vector<glm::vec3>& points)
+	{
+		// make room for the expected triangulation
+		ReservePools(points);
+
+		// determine root triangle
+		DetermineRootTriangle(points);
+
+		// determine the order in which points are added
+		DetermineInsertionOrder(points);
+
+		// add points to triangulation
+		DELAUNAY_STATS_TIMER(stats.insertionTime);
+		if (algorithm == DelaunayAlgorithm::PARALLEL_INCREMENTAL && pointLocation == DelaunayPointLocation::WALK)
+		{
+			AddPointsToTriangulationInParallel(points);
+		}
+		else
+		{
+			AddPointsToTriangulation(points);
+		}
+	}
+
+	// Reserve pools
+	void ReservePools(const std::vector<glm::vec3>& points)
+	{
+		// every point splits one triangle into three (or two into four), and the flips are done in place unless the history
+		// DAG is kept; the flipped triangles of the history are handled by growing the pools on demand
+		size_t numPoints = points.size();
+		size_t numTriangles = 3 * numPoints + 1;
+
+		trianglesPool.Reserve(numTriangles);
+		edgesPool.Reserve(3 * numTriangles);
+		verticesPool.Reserve(numPoints + 3);
+	}
+
+	// Get a new DelaunayTriangle from the pool
+	DelaunayTriangle* GetNewDelaunayTriangle()
+	{
+		DelaunayTriangle* triangle = trianglesPool.GetNew();
+		if (trackTouchedTriangles)
+		{
+			touchedTriangles.push_back(triangle);
+		}
+
+		return triangle;
+	}
+
+	// Get a new DelaunayEdge from the pool
+	DelaunayEdge* GetNewDelaunayEdge()
+	{
+		return edgesPool.GetNew();
+	}
+
+	// Get a new DelaunayVertex from the pool
+	DelaunayVertex* GetNewDelaunayVertex()
+	{
+		return verticesPool.GetNew();
+	}
+
+	// Determine root triangle
+	void DetermineRootTriangle(const std::vector<glm::vec3>& points)
+	{
+		DELAUNAY_STATS_TIMER(stats.rootTriangleTime);
+
+		// get the bounding box of the points
+		glm::vec3 topLeft;
+		glm::vec3 bottomRight;
+		GetBoundingBox(points, topLeft, bottomRight);
+
+		// with integer coordinates the lattice covers the points, as the one of the engines
+		if (integerCoordinates)
+		{
+			DetermineLattice(topLeft, bottomRight);
+		}
+
+		// The legality test treats the root vertices symbolically, so the root triangle only needs to contain the points
+		// with some room to spare (an absolute expansion would be too much for small clouds and too little for big ones)
+		float size = std::max(std::max(bottomRight.x - topLeft.x, bottomRight.z - topLeft.z), 1.0f);
+		float expansion = s_rootTriangleExpansion * size;
+		topLeft.x -= expansion;
+		topLeft.z -= expansion;
+		bottomRight.x += expansion;
+		bottomRight.z += expansion;
+
+		// calculate the super triangle that contains the bounding box
+		// The intersection points of the 3 lines that define the triangle will be the vertices of the triangle
+
+		// calculate the lines that forms the triangle
+		float A1, B1, C1;
+		Geom2DTest::GetLine(topLeft, glm::vec3(topLeft.x + 1.0f, 0.0f, topLeft.z - 1.0f), A1, B1, C1);
+
+		float A2, B2, C2;
+		Geom2DTest::GetLine(glm::vec3(bottomRight.x, 0.0f, topLeft.z), glm::vec3(bottomRight.x - 1.0f, 0.0f, topLeft.z - 1.0f), A2, B2, C2);
+
+		float A3, B3, C3;
+		Geom2DTest::GetLine(glm::vec3(topLeft.x, 0.0f, bottomRight.z), bottomRight, A3, B3, C3);
+
+		// calculate triangle vertices
+		glm::vec3 v1, v2, v3;
+		Geom2DTest::LinesIntersects(A1, B1, C1, A2, B2, C2, v1);
+		Geom2DTest::LinesIntersects(A1, B1, C1, A3, B3, C3, v2);
+		Geom2DTest::LinesIntersects(A2, B2, C2, A3, B3, C3, v3);
+
+		// the root vertices go to the lattice too, but they are usually out of its range (see Orient2D)
+		if (integerCoordinates)
+		{
+			v1 = QuantizePosition(v1);
+			v2 = QuantizePosition(v2);
+			v3 = QuantizePosition(v3);
+		}
+
+		// set root triangle with adjacency information
+		rootTriangle = GetNewDelaunayTriangle();
+
+		lastTriangle = rootTriangle;
+
+		// set adjacency information
+		//
+		// get new half-edges
+		DelaunayEdge* edgeA = GetNewDelaunayEdge();
+		DelaunayEdge* edgeB = GetNewDelaunayEdge();
+		DelaunayEdge* edgeC = GetNewDelaunayEdge();
+
+		// root face edge
+		rootTriangle->edge = edgeA;
+
+		// root half-edge faces
+		edgeA->face = edgeB->face = edgeC->face = rootTriangle;
+
+		// root half-edge order
+		SetEdgesOrderRelationship(edgeA, edgeB, edgeC);
+
+		// root half-edge twins
+		SetEdgesTwinRelationship(edgeA, nullptr);
+		SetEdgesTwinRelationship(edgeB, nullptr);
+		SetEdgesTwinRelationship(edgeC, nullptr);
+
+		// get new vertices
+		DelaunayVertex* vertexA = GetNewDelaunayVertex();
+		vertexA->v = v1;
+		vertexA->edge = edgeA;
+
+		DelaunayVertex* vertexB = GetNewDelaunayVertex();
+		vertexB->v = v2;
+		vertexB->edge = edgeB;
+
+		DelaunayVertex* vertexC = GetNewDelaunayVertex();
+		vertexC->v = v3;
+		vertexC->edge = edgeC;
+
+		rootVertices[0] = vertexA;
+		rootVertices[1] = vertexB;
+		rootVertices[2] = vertexC;
+
+		// hald-edge start vertex
+		SetEdgesVertexRelationship(edgeA, vertexA);
+		SetEdgesVertexRelationship(edgeB, vertexB);
+		SetEdgesVertexRelationship(edgeC, vertexC);
+	}
+
+	// Determine the lattice of the integer coordinates for the box: the largest power of 2 scale that keeps the coordinates
+	// of the box below 2^s_latticeBits in magnitude once scaled (the box is taken at least as big as the unit, like the
+	// root triangle, so the scale stays a float)
+	void DetermineLattice(const glm::vec3& topLeft, const glm::vec3& bottomRight)
+	{
+		float maxCoordinate = std::max(std::max(std::abs(topLeft.x), std::abs(topLeft.z)), std::max(std::abs(bottomRight.x), std::abs(bottomRight.z)));
+
+		int exponent;
+		std::frexp(std::max(maxCoordinate, 1.0f), &exponent);
+
+		latticeScale = std::ldexp(1.0f, s_latticeBits - exponent);
+	}
+
+	// Snap the position to the lattice of the integer coordinates (if they are used). The scale is a power of 2, so the
+	// scaling is exact and the rounded coordinates are floats on the lattice
+	glm::vec3 QuantizePosition(const glm::vec3& position) const
+	{
+		if (latticeScale == 0.0f)
+		{
+			return position;
+		}
+
+		return glm::vec3(std::round(position.x * latticeScale) / latticeScale, position.y, std::round(position.z * latticeScale) / latticeScale);
+	}
+
+	// Is the position of the triangulation in the range of the lattice, where the integer predicates are exact. The lattice
+	// covers the point cloud, so the root vertices (and the points inserted far from the cloud) are usually out of it
+	bool IsInLatticeRange(const glm::vec3& position) const
+	{
+		const float range = (float)(1 << s_latticeBits);
+		return latticeScale > 0.0f && std::abs(position.x) * latticeScale < range && std::abs(position.z) * latticeScale < range;
+	}
+
+	// Orientation of the triangle (a, b, c) of points of the triangulation (> 0 counter-clockwise, < 0 clockwise, 0
+	// collinear), with the integer predicate when the points are on the lattice. Every position of the triangulation is
+	// a float on the lattice, so the adaptive predicate used out of its range is exact too and both agree
+	double Orient2D(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) const
+	{
+		if (IsInLatticeRange(a) && IsInLatticeRange(b) && IsInLatticeRange(c))
+		{
+			return Geom2DTest::Orient2DInteger(a, b, c, latticeScale);
+		}
+
+		return Geom2DTest::Orient2D(a, b, c);
+	}
+
+	// In circle test of the point d against the triangle (a, b, c) of points of the triangulation (> 0 inside the circumcircle
+	// when (a, b, c) is counter-clockwise), with the integer predicate when the points are on the lattice (as Orient2D)
+	double InCircle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d) const
+	{
+		if (IsInLatticeRange(a) && IsInLatticeRange(b) && IsInLatticeRange(c) && IsInLatticeRange(d))
+		{
+			return Geom2DTest::InCircleInteger(a, b, c, d, latticeScale);
+		}
+
+		return Geom2DTest::InCircle(a, b, c, d);
+	}
+
+	// Get the bounding box (actually rectangle) of the points
+	void GetBoundingBox(const std::vector<glm::vec3>& points, glm::vec3& topLeft, glm::vec3& bottomRight)
+	{
+		topLeft = bottomRight = points.empty() ? glm::vec3() : points[0];
+
+		for (auto& point : points)
+		{
+			topLeft.x = std::min(topLeft.x, point.x);
+			topLeft.z = std::min(topLeft.z, point.z);
+
+			bottomRight.x = std::max(bottomRight.x, point.x);
+			bottomRight.z = std::max(bottomRight.z, point.z);
+		}
+	}
+
+	// Is the point strictly inside the root triangle (whose vertices are clockwise), once snapped to the lattice like the
+	// points added
+	bool IsPointInsideRootTriangle(const glm::vec3& position)
+	{
+		glm::vec3 point = QuantizePosition(position);
+		for (int i = 0; i < 3; i++)
+		{
+			if (Orient2D(rootVertices[i]->v, rootVertices[(i + 1) % 3]->v, point) >= 0.0)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Determine insertion order
+	void DetermineInsertionOrder(const std::vector<glm::vec3>& points)
+	{
+		switch (insertionOrder)
+		{
+		case DelaunayInsertionOrder::AS_GIVEN:
+			insertionIndices.resize(points.size());
+			std::iota(insertionIndices.begin(), insertionIndices.end(), 0);
+			break;
+		case DelaunayInsertionOrder::BRIO_HILBERT:
+			SpatialSort::BiasedRandomizedInsertionOrder(points, insertionIndices);
+			break;
+		}
+	}
+
+	// Add points to triangulation
+	void AddPointsToTriangulation(const std::vector<glm::vec3>& points)
+	{
+		for (auto index : insertionIndices)
+		{
+			AddPointToTriangulation(points[index]);
+		}
+	}
+
+	// Add point to triangulation, returning its vertex (nullptr if the point is outside the root triangle)
+	DelaunayVertex* AddPointToTriangulation(const glm::vec3& position)
+	{
+		glm::vec3 point = QuantizePosition(position);
+
+		// get the triangle in which the point lies
+		DelaunayTriangle* triangle = LocateTriangle(point);
+		//assert(triangle);
+		if (!triangle)
+		{
+			// no triangle found
+			DELAUNAY_STATS_COUNT(stats.failedLocations, 1);
+			return nullptr;
+		}
+		// a point that is already in the triangulation is not added again
+		DelaunayVertex* vertex = GetTriangleVertexWithPoint(triangle, point);
+		if (vertex)
+		{
+			return vertex;
+		}
+
+		// check if the point lies in one of the edges of the triangle found
+		DelaunayEdge* edge = GetTriangleEdgeWithPoint(triangle, point);
+		if (edge)
+		{
+			// split adjacent triangles
+			return SplitAdjacentTriangles(edge, point);
+		}
+		else
+		{
+			// split triangle
+			return SplitTriangle(triangle, point);
+		}
+	}
+
+	// Find the vertex of the point (nullptr if the point is not in the triangulation)
+	DelaunayVertex* FindVertex(const glm::vec3& position)
+	{
+		glm::vec3 point = QuantizePosition(position);
+		DelaunayTriangle* triangle = LocateTriangle(point);
+		return triangle ? GetTriangleVertexWithPoint(triangle, point) : nullptr;
+	}
+
+	// Give the touched triangles that were split (and their edges) back to the pools, taking them out of the history (the
+	// root triangle stays, as the root of what is left of it)
+	void ReleaseSplitTriangles()
+	{
+		// picked first, as they become leaves when their children are released
+		for (auto triangle : touchedTriangles)
+		{
+			if (!triangle->IsLeaf() && triangle != rootTriangle)
+			{
+				releasedTriangles.push_back(triangle);
+			}
+		}
+
+		ReleaseTriangles();
+	}
+
+	// Give every triangle that was split (and its edges) back to the pools once the triangulation is built, with the walk
+	// point location. The edits only release the triangles they split, and taking their children away would otherwise
+	// leave the ones split before without children, looking like leaves of the triangulation with their stale edges
+	void ReleaseAllSplitTriangles()
+	{
+		if (pointLocation != DelaunayPointLocation::WALK)
+		{
+			return;
+		}
+
+		for (size_t i = 0; i < trianglesPool.NumUsed(); i++)
+		{
+			DelaunayTriangle* triangle = &trianglesPool[i];
+			if (!triangle->IsLeaf() && triangle != rootTriangle)
+			{
+				releasedTriangles.push_back(triangle);
+			}
+		}
+
+		ReleaseTriangles();
+	}
+
+	// Give the split triangles picked for release (and their edges) back to the pools, taking them out of the history
+	void ReleaseTriangles()
+	{
+		for (auto triangle : releasedTriangles)
+		{
+			for (int i = 0; i < triangle->numChildren; i++)
+			{
+				triangle->children[i]->parent = nullptr;
+			}
+
+			if (triangle->parent)
+			{
+				triangle->parent->RemoveChild(triangle);
+			}
+
+			DelaunayEdge* edge = triangle->edge;
+			for (int i = 0; i < 3; i++)
+			{
+				DelaunayEdge* nextEdge = edge->next;
+				edgesPool.Free(edge);
+				edge = nextEdge;
+			}
+
+			trianglesPool.Free(triangle);
+		}
+
+		releasedTriangles.clear();
+	}
+
+	// Remove the vertex from the triangulation (walk point location only)
+	void RemoveVertexFromTriangulation(DelaunayVertex* vertex)
+	{
+		// The triangles around the vertex form a polygon, closed because every point lies inside the root triangle. Each
+		// triangle (p, a, b) gives the polygon vertex a and the edge (a, b), which is kept with its twin outside the polygon
+		holeVertices.clear();
+		holeEdges.clear();
+		holeTriangles.clear();
+
+		DelaunayEdge* edge = vertex->edge;
+		do
+		{
+			holeVertices.push_back(edge->next->v);
+			holeEdges.push_back(edge->next);
+			holeTriangles.push_back(edge->face);
+
+			edge = edge->next->next->twin;
+		} while (edge != vertex->edge);
+
+		// the edges around the vertex are released, and so are its triangles beyond the ones the polygon needs
+		edge = vertex->edge;
+		do
+		{
+			DelaunayEdge* nextEdge = edge->next->next->twin;
+
+			edgesPool.Free(edge->next->next);
+			edgesPool.Free(edge);
+
+			edge = nextEdge;
+		} while (edge != vertex->edge);
+
+		verticesPool.Free(vertex);
+
+		for (auto triangle : holeTriangles)
+		{
+			triangle->edge = nullptr;
+
+			if (trackTouchedTriangles)
+			{
+				touchedTriangles.push_back(triangle);
+			}
+		}
+
+		// clip ears until the polygon is a triangle. Clipping the ear (a, b, c) adds the triangle (a, b, c) and leaves the
+		// new edge (a, c) in the polygon
+		size_t numHoleTriangles = 0;
+		while (holeVertices.size() > 3)
+		{
+			size_t ear = FindHoleEar();
+
+			size_t numVertices = holeVertices.size();
+			size_t b = (ear + 1) % numVertices;
+			size_t c = (ear + 2) % numVertices;
+
+			DelaunayEdge* edgeCA = GetNewDelaunayEdge();
+			DelaunayEdge* edgeAC = GetNewDelaunayEdge();
+			SetEdgesVertexRelationship(edgeCA, holeVertices[c]);
+			SetEdgesVertexRelationship(edgeAC, holeVertices[ear]);
+			SetEdgesTwinRelationship(edgeCA, edgeAC);
+
+			SetHoleTriangle(holeTriangles[numHoleTriangles++], holeEdges[ear], holeEdges[b], edgeCA);
+
+			edgesToLegalize.push_back(edgeAC);
+
+			holeEdges[ear] = edgeAC;
+			holeVertices.erase(holeVertices.begin() + b);
+			holeEdges.erase(holeEdges.begin() + b);
+		}
+
+		SetHoleTriangle(holeTriangles[numHoleTriangles++], holeEdges[0], holeEdges[1], holeEdges[2]);
+
+		releasedTriangles.insert(releasedTriangles.end(), holeTriangles.begin() + numHoleTriangles, holeTriangles.end());
+
+		// the polygon vertices may have lost their edge with the vertex
+		for (size_t i = 0; i < numHoleTriangles; i++)
+		{
+			DelaunayEdge* holeEdge = holeTriangles[i]->edge;
+			for (int j = 0; j < 3; j++, holeEdge = holeEdge->next)
+			{
+				holeEdge->v->edge = holeEdge;
+			}
+		}
+
+		lastTriangle = holeTriangles[0];
+
+		LegalizeAllEdges();
+	}
+
+	// Find an ear of the polygon left by the vertex being removed, returning the polygon index of its first vertex. The ear
+	// (a, b, c) has to be convex and hold no other vertex of the polygon, and the ones whose circumcircle holds no other
+	// vertex of the polygon either come first (their triangle is already Delaunay)
+	size_t FindHoleEar()
+	{
+		size_t numVertices = holeVertices.size();
+		size_t firstEar = numVertices;
+
+		for (size_t i = 0; i < numVertices; i++)
+		{
+			const DelaunayVertex* a = holeVertices[i];
+			const DelaunayVertex* b = holeVertices[(i + 1) % numVertices];
+			const DelaunayVertex* c = holeVertices[(i + 2) % numVertices];
+
+			// the triangles are clockwise
+			if (Geom2DTest::Orient2D(a->v, b->v, c->v) >= 0.0)
+			{
+				continue;
+			}
+
+			bool isEar = true;
+			bool isDelaunay = !IsRootVertex(a) && !IsRootVertex(b) && !IsRootVertex(c);
+			for (size_t j = 3; isEar && j < numVertices; j++)
+			{
+				const DelaunayVertex* d = holeVertices[(i + j) % numVertices];
+
+				isEar = !Geom2DTest::PointInTriangle(d->v, a->v, b->v, c->v);
+				isDelaunay = isDelaunay && (IsRootVertex(d) || Geom2DTest::InCircle(a->v, c->v, b->v, d->v) <= 0.0);
+			}
+
+			if (isEar && isDelaunay)
+			{
+				return i;
+			}
+
+			if (isEar && firstEar == numVertices)
+			{
+				firstEar = i;
+			}
+		}
+
+		assert(firstEar < numVertices);
+		return firstEar;
+	}
+
+	// Set the triangle of the polygon left by the vertex being removed from its three edges
+	void SetHoleTriangle(DelaunayTriangle* triangle, DelaunayEdge* edgeA, DelaunayEdge* edgeB, DelaunayEdge* edgeC)
+	{
+		triangle->edge = edgeA;
+		edgeA->face = edgeB->face = edgeC->face = triangle;
+
+		SetEdgesOrderRelationship(edgeA, edgeB, edgeC);
+	}
+
+	// Get the end points of the constrained edges of the triangulation, two by two
+	void GetConstrainedSegments(std::vector<glm::vec3>& segments)
+	{
+		for (auto triangle : meshTriangles)
+		{
+			DelaunayEdge* edge = triangle->edge;
+			for (int i = 0; i < 3; i++, edge = edge->next)
+			{
+				// every edge once, from the half-edge whose twin is missing or comes later
+				if (edge->constrained && (!edge->twin || edge->twin->face->exportIndex < 0 || edge < edge->twin))
+				{
+					segments.push_back(edge->v->v);
+					segments.push_back(edge->next->v->v);
+				}
+			}
+		}
+	}
+
+	// Insert the segment (a, b) between two vertices as a constrained edge (walk point location only)
+	void InsertConstrainedSegment(DelaunayVertex* vertexA, DelaunayVertex* vertexB)
+	{
+		while (vertexA && vertexB && vertexA != vertexB)
+		{
+			vertexA = InsertConstrainedSegmentPart(vertexA, vertexB);
+		}
+	}
+
+	// Insert the segment (a, b) as a constrained edge up to the first vertex it reaches, returning that vertex: b, a vertex
+	// the segment goes through or the one added where the segment crosses another constrained edge
+	DelaunayVertex* InsertConstrainedSegmentPart(DelaunayVertex* vertexA, DelaunayVertex* vertexB)
+	{
+		const glm::vec3& a = vertexA->v;
+		const glm::vec3& b = vertexB->v;
+
+		// find the triangle (a, q, r) around a that the segment leaves across the edge (q, r), unless the segment ends at
+		// one of the vertices of a or goes through it
+		DelaunayEdge* crossedEdge = nullptr;
+
+		DelaunayEdge* edge = vertexA->edge;
+		do
+		{
+			DelaunayVertex* vertexQ = edge->next->v;
+			DelaunayVertex* vertexR = edge->next->next->v;
+
+			double sideQ = Geom2DTest::Orient2D(a, b, vertexQ->v);
+			double sideR = Geom2DTest::Orient2D(a, b, vertexR->v);
+
+			bool towardsQ = glm::dot(glm::vec2(vertexQ->v.x - a.x, vertexQ->v.z - a.z), glm::vec2(b.x - a.x, b.z - a.z)) > 0.0f;
+			if (vertexQ == vertexB || (sideQ == 0.0 && towardsQ && !IsRootVertex(vertexQ)))
+			{
+				edge->constrained = edge->twin->constrained = true;
+				return vertexQ;
+			}
+
+			if (((sideQ > 0.0 && sideR < 0.0) || (sideQ < 0.0 && sideR > 0.0)) && Geom2DTest::Orient2D(vertexQ->v, vertexR->v, b) > 0.0)
+			{
+				crossedEdge = edge->next;
+				break;
+			}
+
+			edge = edge->next->next->twin;
+		} while (edge != vertexA->edge);
+
+		assert(crossedEdge);
+		if (!crossedEdge)
+		{
+			return vertexB;
+		}
+
+		// Walk across the edges crossed by the segment, each of them going from the vertex on one side (side 0) to the
+		// vertex on the other (side 1). The triangles crossed are replaced, and the edges of their sides that are not
+		// crossed make the polygons at both sides of the segment
+		holeTriangles.clear();
+		holeEdges.clear();
+
+		double side0 = Geom2DTest::Orient2D(a, b, crossedEdge->v->v);
+		for (int side = 0; side < 2; side++)
+		{
+			polygonVertices[side].clear();
+			polygonVertices[side].push_back(vertexA);
+			polygonEdges[side].clear();
+		}
+
+		holeTriangles.push_back(crossedEdge->face);
+		polygonVertices[0].push_back(crossedEdge->v);
+		polygonEdges[0].push_back(crossedEdge->next->next);
+		polygonVertices[1].push_back(crossedEdge->next->v);
+		polygonEdges[1].push_back(crossedEdge->next);
+
+		DelaunayVertex* vertexEnd = nullptr;
+		while (!vertexEnd)
+		{
+			if (crossedEdge->constrained)
+			{
+				// the segment goes on from the vertex added where it meets the other constrained edge
+				DelaunayVertex* vertexX = SplitConstrainedEdgeAtSegment(crossedEdge, vertexA, vertexB);
+				InsertConstrainedSegment(vertexA, vertexX);
+
+				return vertexX;
+			}
+
+			DelaunayEdge* twin = crossedEdge->twin;
+			DelaunayVertex* vertexS = twin->next->next->v;
+
+			holeTriangles.push_back(twin->face);
+			holeEdges.push_back(crossedEdge);
+
+			double sideS = Geom2DTest::Orient2D(a, b, vertexS->v);
+			if (vertexS == vertexB || sideS == 0.0)
+			{
+				// the segment ends at s (or goes through it)
+				vertexEnd = vertexS;
+
+				polygonVertices[0].push_back(vertexS);
+				polygonEdges[0].push_back(twin->next);
+				polygonVertices[1].push_back(vertexS);
+				polygonEdges[1].push_back(twin->next->next);
+			}
+			else if ((sideS > 0.0) == (side0 > 0.0))
+			{
+				polygonVertices[0].push_back(vertexS);
+				polygonEdges[0].push_back(twin->next);
+				crossedEdge = twin->next->next;
+			}
+			else
+			{
+				polygonVertices[1].push_back(vertexS);
+				polygonEdges[1].push_back(twin->next->next);
+				crossedEdge = twin->next;
+			}
+		}
+
+		// the edges crossed are released, and the triangles crossed are reused for the polygons (as many as before)
+		for (auto holeEdge : holeEdges)
+		{
+			edgesPool.Free(holeEdge->twin);
+			edgesPool.Free(holeEdge);
+		}
+
+		for (auto triangle : holeTriangles)
+		{
+			if (trackTouchedTriangles)
+			{
+				touchedTriangles.push_back(triangle);
+			}
+		}
+
+		// the segment, with a half-edge in each polygon
+		DelaunayEdge* segmentEdges[2] = { GetNewDelaunayEdge(), GetNewDelaunayEdge() };
+		SetEdgesTwinRelationship(segmentEdges[0], segmentEdges[1]);
+		segmentEdges[0]->constrained = segmentEdges[1]->constrained = true;
+
+		size_t numHoleTriangles = 0;
+		for (int side = 0; side < 2; side++)
+		{
+			TriangulatePseudoPolygon(side, 0, polygonVertices[side].size() - 1, segmentEdges[side], numHoleTriangles);
+		}
+		assert(numHoleTriangles == holeTriangles.size());
+
+		// the vertices may have lost their edge with the triangles crossed
+		for (auto triangle : holeTriangles)
+		{
+			DelaunayEdge* holeEdge = triangle->edge;
+			for (int j = 0; j < 3; j++, holeEdge = holeEdge->next)
+			{
+				holeEdge->v->edge = holeEdge;
+			}
+		}
+
+		lastTriangle = holeTriangles[0];
+
+		return vertexEnd;
+	}
+
+	// Triangulate the part of the polygon of the side of the segment between its vertices first and last, where the edge
+	// (first, last) is inner. The vertex c of the triangle (first, c, last) is the one whose circumcircle holds no other
+	// vertex of the part, and the parts (first, c) and (c, last) are triangulated the same way
+	void TriangulatePseudoPolygon(int side, size_t first, size_t last, DelaunayEdge* inner, size_t& numHoleTriangles)
+	{
+		std::vector<DelaunayVertex*>& vertices = polygonVertices[side];
+		std::vector<DelaunayEdge*>& edges = polygonEdges[side];
+
+		const glm::vec3& a = vertices[first]->v;
+		const glm::vec3& b = vertices[last]->v;
+
+		size_t c = first + 1;
+		for (size_t i = first + 2; i < last; i++)
+		{
+			// a vertex inside the circumcircle of (a, c, b), whatever its winding
+			double inCircle = Geom2DTest::InCircle(a, vertices[c]->v, b, vertices[i]->v);
+			if (Geom2DTest::Orient2D(a, vertices[c]->v, b) < 0.0)
+			{
+				inCircle = -inCircle;
+			}
+
+			if (inCircle > 0.0)
+			{
+				c = i;
+			}
+		}
+
+		// sides (first, c) and (c, last), either edges of the polygon or new edges inner to the parts
+		DelaunayEdge* sides[2];
+		size_t ends[3] = { first, c, last };
+		for (int i = 0; i < 2; i++)
+		{
+			if (ends[i + 1] == ends[i] + 1)
+			{
+				sides[i] = edges[ends[i]];
+			}
+			else
+			{
+				DelaunayEdge* partInner = GetNewDelaunayEdge();
+				sides[i] = GetNewDelaunayEdge();
+				SetEdgesTwinRelationship(sides[i], partInner);
+
+				TriangulatePseudoPolygon(side, ends[i], ends[i + 1], partInner, numHoleTriangles);
+			}
+		}
+
+		DelaunayVertex* vertexA = vertices[first];
+		DelaunayVertex* vertexC = vertices[c];
+		DelaunayVertex* vertexB = vertices[last];
+
+		DelaunayTriangle* triangle = holeTriangles[numHoleTriangles++];
+		if (Geom2DTest::Orient2D(a, vertexC->v, b) < 0.0)
+		{
+			// clockwise (a, c, b)
+			SetEdgesVertexRelationship(sides[0], vertexA);
+			SetEdgesVertexRelationship(sides[1], vertexC);
+			SetEdgesVertexRelationship(inner, vertexB);
+			SetHoleTriangle(triangle, sides[0], sides[1], inner);
+		}
+		else
+		{
+			// clockwise (a, b, c)
+			SetEdgesVertexRelationship(inner, vertexA);
+			SetEdgesVertexRelationship(sides[1], vertexB);
+			SetEdgesVertexRelationship(sides[0], vertexC);
+			SetHoleTriangle(triangle, inner, sides[1], sides[0]);
+		}
+	}
+
+	// Split the constrained edge (q, r) crossed by the segment (a, b) where they meet, returning the vertex added. When the
+	// point where they meet is at one of the vertices, in floating point, that vertex is returned instead: q or r, or the
+	// apex s of a triangle of the edge, and then the constrained edge goes through s (the edges (q, s) and (s, r) take the
+	// constraint, so the segment can cross (q, r) to get to s)
+	DelaunayVertex* SplitConstrainedEdgeAtSegment(DelaunayEdge* edge, const DelaunayVertex* vertexA, const DelaunayVertex* vertexB)
+	{
+		const glm::vec3& a = vertexA->v;
+		const glm::vec3& b = vertexB->v;
+		DelaunayVertex* vertexQ = edge->v;
+		DelaunayVertex* vertexR = edge->next->v;
+
+		// the point is on the segment, with the height of the constrained edge
+		double sideA = Geom2DTest::Orient2D(vertexQ->v, vertexR->v, a);
+		double sideB = Geom2DTest::Orient2D(vertexQ->v, vertexR->v, b);
+		double sideQ = Geom2DTest::Orient2D(a, b, vertexQ->v);
+		double sideR = Geom2DTest::Orient2D(a, b, vertexR->v);
+
+		float t = (float)(sideA / (sideA - sideB));
+		float u = (float)(sideQ / (sideQ - sideR));
+
+		glm::vec3 point = QuantizePosition(a + t * (b - a));
+		point.y = vertexQ->v.y + u * (vertexR->v.y - vertexQ->v.y);
+
+		const glm::vec3* ends[4] = { &a, &b, &vertexQ->v, &vertexR->v };
+		for (auto end : ends)
+		{
+			if (end->x == point.x && end->z == point.z)
+			{
+				return (u < 0.5f) ? vertexQ : vertexR;
+			}
+		}
+
+		DelaunayEdge* edges[2] = { edge, edge->twin };
+		for (auto triangleEdge : edges)
+		{
+			DelaunayVertex* vertexS = triangleEdge->next->next->v;
+			if (vertexS->v.x == point.x && vertexS->v.z == point.z)
+			{
+				DelaunayEdge* constrainedEdges[4] = { triangleEdge->next, triangleEdge->next->twin, triangleEdge->next->next, triangleEdge->next->next->twin };
+				for (auto constrainedEdge : constrainedEdges)
+				{
+					constrainedEdge->constrained = true;
+				}
+
+				edge->constrained = false;
+				edge->twin->constrained = false;
+
+				return vertexS;
+			}
+		}
+
+		return SplitAdjacentTriangles(edge, point);
+	}
+
+	// Refine the triangulation (the bounds are set): the segments encroached by a vertex are split first, and then the worst
+	// bad triangle gets its Steiner point. The triangles touched on the way are checked in turn
+	void RefineTriangulation()
+	{
+		badTriangles.clear();
+		encroachedSegments.clear();
+
+		for (auto triangle : meshTriangles)
+		{
+			QueueRefinement(triangle);
+		}
+
+		size_t numChecked = 0;
+		while (!encroachedSegments.empty() || !badTriangles.empty())
+		{
+			if (!encroachedSegments.empty())
+			{
+				RefinementSegment segment = encroachedSegments.back();
+				encroachedSegments.pop_back();
+
+				// it could have been split already
+				if (IsTriangulationTriangle(segment.edge->face) && segment.edge->v == segment.vertexA && segment.edge->next->v == segment.vertexB)
+				{
+					SplitSegment(segment.edge);
+				}
+			}
+			else
+			{
+				std::pop_heap(badTriangles.begin(), badTriangles.end());
+				DelaunayTriangle* triangle = badTriangles.back().triangle;
+				badTriangles.pop_back();
+
+				// it could have been split or flipped since it was queued
+				double quality;
+				if (IsTriangulationTriangle(triangle) && IsBadTriangle(triangle, quality))
+				{
+					AddSteinerPoint(triangle, quality);
+				}
+			}
+
+			for (; numChecked < touchedTriangles.size(); numChecked++)
+			{
+				if (IsTriangulationTriangle(touchedTriangles[numChecked]))
+				{
+					QueueRefinement(touchedTriangles[numChecked]);
+				}
+			}
+		}
+	}
+
+	// Queue the segments of the triangle encroached by its opposite vertex, and the triangle itself when it is bad
+	void QueueRefinement(DelaunayTriangle* triangle)
+	{
+		DelaunayEdge* edge = triangle->edge;
+		for (int i = 0; i < 3; i++, edge = edge->next)
+		{
+			if (IsSegment(edge) && IsSegmentEncroached(edge, edge->next->next->v->v))
+			{
+				QueueEncroachedSegment(edge);
+			}
+		}
+
+		double quality;
+		if (IsBadTriangle(triangle, quality))
+		{
+			badTriangles.push_back({ quality, triangle });
+			std::push_heap(badTriangles.begin(), badTriangles.end());
+		}
+	}
+
+	// Queue the segment to be split, unless its halves would be shorter than the shortest edge refined. Returns whether it
+	// was queued
+	bool QueueEncroachedSegment(DelaunayEdge* edge)
+	{
+		double x = (double)edge->next->v->v.x - edge->v->v.x;
+		double z = (double)edge->next->v->v.z - edge->v->v.z;
+		if (x * x + z * z < 4.0 * refinementMinLength)
+		{
+			return false;
+		}
+
+		encroachedSegments.push_back({ edge, edge->v, edge->next->v });
+
+		return true;
+	}
+
+	// Split the segment at its midpoint (which is taken as lying on it, even if it falls a bit off it in floating point)
+	void SplitSegment(DelaunayEdge* edge)
+	{
+		SplitAdjacentTriangles(edge, QuantizePosition(0.5f * (edge->v->v + edge->next->v->v)));
+	}
+
+	// Is the triangle bad (its angle or its area are out of the bounds), giving its quality. An angle smaller than the
+	// minimum between two segments is left as it is, as splitting the triangle would not fix it, and so is a triangle
+	// whose shortest edge is shorter than the shortest edge refined
+	bool IsBadTriangle(const DelaunayTriangle* triangle, double& quality)
+	{
+		DelaunayEdge* edges[3] = { triangle->edge, triangle->edge->next, triangle->edge->next->next };
+
+		double lengths[3];
+		int shortest = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			const glm::vec3& a = edges[i]->v->v;
+			const glm::vec3& b = edges[(i + 1) % 3]->v->v;
+			double x = (double)b.x - a.x;
+			double z = (double)b.z - a.z;
+			lengths[i] = x * x + z * z;
+
+			if (lengths[i] < lengths[shortest])
+			{
+				shortest = i;
+			}
+		}
+
+		// twice the area (the triangle is clockwise). The squared circumradius is the product of the squared lengths over
+		// 4 times the squared double area
+		double doubleArea = -Geom2DTest::Orient2D(edges[0]->v->v, edges[1]->v->v, edges[2]->v->v);
+		if (doubleArea <= 0.0)
+		{
+			quality = 0.0;
+			return false;
+		}
+
+		quality = lengths[0] * lengths[1] * lengths[2] / (4.0 * doubleArea * doubleArea * lengths[shortest]);
+		if (lengths[shortest] < refinementMinLength)
+		{
+			return false;
+		}
+
+		// the smallest angle is the one opposite to the shortest edge, between the other two
+		bool badAngle = quality > refinementMaxQuality && !(IsSegment(edges[(shortest + 1) % 3]) && IsSegment(edges[(shortest + 2) % 3]));
+		bool badArea = refinementMaxArea > 0.0 && 0.5 * doubleArea > refinementMaxArea;
+
+		return badAngle || badArea;
+	}
+
+	// Is the edge of a triangle of the triangulation a segment kept by the refinement: a breakline or a convex hull edge
+	// (the triangle beyond has a root vertex, which can only be the opposite one)
+	bool IsSegment(const DelaunayEdge* edge) const
+	{
+		return edge->constrained || !edge->twin || IsRootVertex(edge->twin->next->next->v);
+	}
+
+	// Is the segment encroached by the point (the point lies strictly inside the circle whose diameter is the segment)
+	bool IsSegmentEncroached(const DelaunayEdge* edge, const glm::vec3& point) const
+	{
+		const glm::vec3& a = edge->v->v;
+		const glm::vec3& b = edge->next->v->v;
+
+		double dot = ((double)a.x - point.x) * ((double)b.x - point.x) + ((double)a.z - point.z) * ((double)b.z - point.z);
+
+		return dot < 0.0;
+	}
+
+	// Add the Steiner point of the bad triangle, its circumcenter, unless it encroaches segments: then the segments are
+	// queued to be split and the triangle is queued again
+	void AddSteinerPoint(DelaunayTriangle* triangle, double quality)
+	{
+		glm::vec3 center = GetCircumcenter(triangle);
+
+		// a segment between the triangle and its circumcenter is encroached by it
+		DelaunayEdge* segment = nullptr;
+		DelaunayTriangle* centerTriangle = WalkToPointUpToSegment(triangle, center, segment);
+		if (!centerTriangle)
+		{
+			if (segment && QueueEncroachedSegment(segment))
+			{
+				badTriangles.push_back({ quality, triangle });
+				std::push_heap(badTriangles.begin(), badTriangles.end());
+			}
+			return;
+		}
+
+		// the segments on the boundary of the cavity of the circumcenter (the triangles whose circumcircle holds it, up to
+		// the segments) are the ones it could encroach
+		bool encroaches = false;
+		refinementCavity.clear();
+		refinementCavity.push_back(centerTriangle);
+		for (size_t i = 0; i < refinementCavity.size(); i++)
+		{
+			DelaunayEdge* edge = refinementCavity[i]->edge;
+			for (int j = 0; j < 3; j++, edge = edge->next)
+			{
+				if (IsSegment(edge))
+				{
+					if (IsSegmentEncroached(edge, center))
+					{
+						encroaches |= QueueEncroachedSegment(edge);
+					}
+					continue;
+				}
+
+				DelaunayTriangle* neighbour = edge->twin->face;
+				const DelaunayEdge* neighbourEdge = neighbour->edge;
+				if (std::find(refinementCavity.begin(), refinementCavity.end(), neighbour) == refinementCavity.end()
+					&& Geom2DTest::InCircle(neighbourEdge->v->v, neighbourEdge->next->next->v->v, neighbourEdge->next->v->v, center) > 0.0)
+				{
+					refinementCavity.push_back(neighbour);
+				}
+			}
+		}
+
+		if (encroaches)
+		{
+			badTriangles.push_back({ quality, triangle });
+			std::push_heap(badTriangles.begin(), badTriangles.end());
+			return;
+		}
+
+		center.y = InterpolateHeight(centerTriangle, center);
+
+		lastTriangle = centerTriangle;
+		AddPointToTriangulation(center);
+	}
+
+	// Circumcenter of the triangle
+	glm::vec3 GetCircumcenter(const DelaunayTriangle* triangle) const
+	{
+		double centerX, centerZ, radius;
+		GetCircumcircle(triangle, centerX, centerZ, radius);
+
+		return glm::vec3((float)centerX, triangle->edge->v->v.y, (float)centerZ);
+	}
+
+	// Circumcircle of the triangle (computed in double precision, relative to its first vertex). The radius of a degenerate
+	// triangle is not finite
+	void GetCircumcircle(const DelaunayTriangle* triangle, double& centerX, double& centerZ, double& radius) const
+	{
+		const glm::vec3& a = triangle->edge->v->v;
+		const glm::vec3& b = triangle->edge->next->v->v;
+		const glm::vec3& c = triangle->edge->next->next->v->v;
+
+		double bx = (double)b.x - a.x;
+		double bz = (double)b.z - a.z;
+		double cx = (double)c.x - a.x;
+		double cz = (double)c.z - a.z;
+
+		double b2 = bx * bx + bz * bz;
+		double c2 = cx * cx + cz * cz;
+		double d = 2.0 * (bx * cz - bz * cx);
+
+		double x = (cz * b2 - bz * c2) / d;
+		double z = (bx * c2 - cx * b2) / d;
+
+		centerX = a.x + x;
+		centerZ = a.z + z;
+		radius = std::sqrt(x * x + z * z);
+	}
+
+	// Walk along the line from the centroid of the triangle to the point, returning the triangle that contains the point.
+	// When a segment is in the way the walk stops there, returning nullptr and the segment
+	DelaunayTriangle* WalkToPointUpToSegment(DelaunayTriangle* triangle, const glm::vec3& point, DelaunayEdge*& segment)
+	{
+		const DelaunayEdge* firstEdge = triangle->edge;
+		glm::vec3 origin = (firstEdge->v->v + firstEdge->next->v->v + firstEdge->next->next->v->v) / 3.0f;
+
+		DelaunayEdge* entryEdge = nullptr;
+		for (size_t step = 0; step < trianglesPool.NumUsed(); step++)
+		{
+			// the line leaves the triangle through an edge the point is beyond, between the ends of the edge (any edge the
+			// point is beyond will do when rounding keeps the line from going between them)
+			DelaunayEdge* exitEdge = nullptr;
+			DelaunayEdge* edge = triangle->edge;
+			for (int i = 0; i < 3; i++, edge = edge->next)
+			{
+				if (edge != entryEdge && Geom2DTest::Orient2D(edge->v->v, edge->next->v->v, point) > 0.0)
+				{
+					double sideA = Geom2DTest::Orient2D(origin, point, edge->v->v);
+					double sideB = Geom2DTest::Orient2D(origin, point, edge->next->v->v);
+					if (!exitEdge || sideA * sideB <= 0.0)
+					{
+						exitEdge = edge;
+					}
+				}
+			}
+
+			if (!exitEdge)
+			{
+				return triangle;
+			}
+
+			if (IsSegment(exitEdge))
+			{
+				segment = exitEdge;
+				return nullptr;
+			}
+
+			entryEdge = exitEdge->twin;
+			triangle = entryEdge->face;
+		}
+
+		return nullptr;
+	}
+
+	// Height of the point inside the triangle, interpolated from its vertices
+	float InterpolateHeight(const DelaunayTriangle* triangle, const glm::vec3& point) const
+	{
+		const glm::vec3& a = triangle->edge->v->v;
+		const glm::vec3& b = triangle->edge->next->v->v;
+		const glm::vec3& c = triangle->edge->next->next->v->v;
+
+		double area = Geom2DTest::Orient2D(a, b, c);
+		if (area == 0.0)
+		{
+			return (a.y + b.y + c.y) / 3.0f;
+		}
+
+		double weightA = Geom2DTest::Orient2D(point, b, c) / area;
+		double weightB = Geom2DTest::Orient2D(a, point, c) / area;
+
+		return (float)(weightA * a.y + weightB * b.y + (1.0 - weightA - weightB) * c.y);
+	}
+
+	// Get the cell of the streamed triangulation where the point lies (false if it is outside the bounds)
+	bool GetStreamCell(const glm::vec3& point, uint32_t& cell) const
+	{
+		if (	point.x < streamTopLeft.x || point.x > streamBottomRight.x
+			||	point.z < streamTopLeft.z || point.z > streamBottomRight.z)
+		{
+			return false;
+		}
+
+		// the points on the far sides of the bounds belong to the last cells
+		uint32_t x = std::min((uint32_t)((point.x - (double)streamTopLeft.x) / streamCellSizeX), numStreamCellsX - 1);
+		uint32_t z = std::min((uint32_t)((point.z - (double)streamTopLeft.z) / streamCellSizeZ), numStreamCellsZ - 1);
+		cell = z * numStreamCellsX + x;
+
+		return true;
+	}
+
+	// Queue the triangle of the streamed triangulation in a cell that its circumcircle overlaps and that is not finalized.
+	// When there is none no point can come inside the circumcircle anymore, so the triangle is final and it is written out
+	void QueueStreamTriangle(DelaunayTriangle* triangle)
+	{
+		double centerX, centerZ, radius;
+		GetCircumcircle(triangle, centerX, centerZ, radius);
+
+		// the circumcircle is a bit larger than computed, so a point that might be inside it never goes unnoticed
+		bool degenerate = !std::isfinite(radius);
+		radius += s_streamCircleTolerance * (radius + std::abs(centerX) + std::abs(centerZ));
+
+		// range of cells under the bounding box of the circumcircle
+		double minX = degenerate ? 0.0 : (centerX - radius - streamTopLeft.x) / streamCellSizeX;
+		double maxX = degenerate ? numStreamCellsX : (centerX + radius - streamTopLeft.x) / streamCellSizeX;
+		double minZ = degenerate ? 0.0 : (centerZ - radius - streamTopLeft.z) / streamCellSizeZ;
+		double maxZ = degenerate ? numStreamCellsZ : (centerZ + radius - streamTopLeft.z) / streamCellSizeZ;
+
+		uint32_t firstX = (uint32_t)glm::clamp(std::floor(minX), 0.0, numStreamCellsX - 1.0);
+		uint32_t lastX = (uint32_t)glm::clamp(std::floor(maxX), 0.0, numStreamCellsX - 1.0);
+		uint32_t firstZ = (uint32_t)glm::clamp(std::floor(minZ), 0.0, numStreamCellsZ - 1.0);
+		uint32_t lastZ = (uint32_t)glm::clamp(std::floor(maxZ), 0.0, numStreamCellsZ - 1.0);
+
+		for (uint32_t z = firstZ; z <= lastZ; z++)
+		{
+			for (uint32_t x = firstX; x <= lastX; x++)
+			{
+				uint32_t cell = z * numStreamCellsX + x;
+				if (finalizedCells[cell])
+				{
+					continue;
+				}
+
+				// distance from the center to the closest point of the cell
+				double cellX = streamTopLeft.x + x * streamCellSizeX;
+				double cellZ = streamTopLeft.z + z * streamCellSizeZ;
+				double dx = std::max(std::max(cellX - centerX, centerX - (cellX + streamCellSizeX)), 0.0);
+				double dz = std::max(std::max(cellZ - centerZ, centerZ - (cellZ + streamCellSizeZ)), 0.0);
+
+				if (degenerate || dx * dx + dz * dz <= radius * radius)
+				{
+					cellTriangles[cell].push_back(triangle);
+					return;
+				}
+			}
+		}
+
+		WriteStreamTriangle(triangle);
+	}
+
+	// Write out the triangle of the streamed triangulation (and its vertices the first time they are used), giving its
+	// memory back to the pools. Its neighbors lose it as twin
+	void WriteStreamTriangle(DelaunayTriangle* triangle)
+	{
+		uint32_t vertices[3];
+
+		DelaunayEdge* edge = triangle->edge;
+		for (int i = 0; i < 3; i++, edge = edge->next)
+		{
+			DelaunayVertex* vertex = edge->v;
+			if (vertex->exportIndex < 0)
+			{
+				vertex->exportIndex = numStreamedVertices++;
+				exporter.StreamVertex(vertex->v);
+				streamedVertices.push_back(vertex);
+			}
+
+			vertices[i] = vertex->exportIndex;
+		}
+
+		exporter.StreamTriangle(vertices[0], vertices[1], vertices[2]);
+
+		edge = triangle->edge;
+		for (int i = 0; i < 3; i++)
+		{
+			DelaunayEdge* nextEdge = edge->next;
+			if (edge->twin)
+			{
+				edge->twin->twin = nullptr;
+			}
+
+			edgesPool.Free(edge);
+			edge = nextEdge;
+		}
+
+		if (triangle == lastTriangle)
+		{
+			lastTriangle = nullptr;
+		}
+
+		trianglesPool.Free(triangle);
+	}
+
+	// Give the vertices written out that no triangle uses anymore back to the pool. They are found by setting the edge of
+	// the vertices of all the triangles left, which is linear over the pool, so it is only done once the vertices written
+	// out since the last time are a fair part of the pool
+	void ReleaseStreamedVertices()
+	{
+		if (streamedVertices.size() - numKeptStreamedVertices < verticesPool.NumUsed() / 4)
+		{
+			return;
+		}
+
+		for (auto vertex : streamedVertices)
+		{
+			vertex->edge = nullptr;
+		}
+
+		for (size_t i = 0; i < trianglesPool.NumUsed(); i++)
+		{
+			DelaunayTriangle& triangle = trianglesPool[i];
+			if (triangle.edge && triangle.IsLeaf())
+			{
+				DelaunayEdge* edge = triangle.edge;
+				for (int j = 0; j < 3; j++, edge = edge->next)
+				{
+					edge->v->edge = edge;
+				}
+			}
+		}
+
+		numKeptStreamedVertices = 0;
+		for (auto vertex : streamedVertices)
+		{
+			if (vertex->edge)
+			{
+				streamedVertices[numKeptStreamedVertices++] = vertex;
+			}
+			else
+			{
+				verticesPool.Free(vertex);
+			}
+		}
+
+		streamedVertices.resize(numKeptStreamedVertices);
+	}
+
+	// Locate the triangle where to add the point when the walk of the streamed triangulation runs into the triangles
+	// written out: walk again from a triangle waiting in the cell of the point, or else look at every triangle left
+	DelaunayTriangle* LocateStreamTriangle(const glm::vec3& point)
+	{
+		uint32_t cell;
+		if (!GetStreamCell(point, cell))
+		{
+			return nullptr;
+		}
+
+		for (auto it = cellTriangles[cell].rbegin(); it != cellTriangles[cell].rend(); ++it)
+		{
+			if ((*it)->edge && (*it)->IsLeaf())
+			{
+				DelaunayTriangle* triangle = WalkToTriangleWhereToAddPoint(point, *it);
+				if (triangle)
+				{
+					return triangle;
+				}
+				break;
+			}
+		}
+
+		for (size_t i = 0; i < trianglesPool.NumUsed(); i++)
+		{
+			DelaunayTriangle* triangle = &trianglesPool[i];
+			// the root triangle is left without children once they are all released, but it is no longer part of it
+			if (!triangle->edge || !triangle->IsLeaf() || triangle == rootTriangle)
+			{
+				continue;
+			}
+
+			const DelaunayEdge* edge = triangle->edge;
+			if (Geom2DTest::PointInTriangle(point, edge->v->v, edge->next->v->v, edge->next->next->v->v))
+			{
+				return triangle;
+			}
+		}
+
+		return nullptr;
+	}
+
+	// Add points to triangulation from several worker threads. The first points are added one by one and the rest in
+	// batches of doubling size (the rounds of the insertion order, roughly), every batch split in contiguous blocks among
+	// the workers so each of them inserts into its own part of the triangulation
+	void AddPointsToTriangulationInParallel(const std::vector<glm::vec3>& points)
+	{
+		size_t numPoints = insertionIndices.size();
+
+		size_t firstParallelPoint = std::min(numPoints, s_parallelFirstBatchSize);
+		for (size_t i = 0; i < firstParallelPoint; i++)
+		{
+			AddPointToTriangulation(points[insertionIndices[i]]);
+		}
+
+		if (firstParallelPoint == numPoints)
+		{
+			return;
+		}
+
+		// every point gets its own two triangles, six half-edges and vertex (the insertion of a point replaces a cavity of
+		// k triangles by k + 2), so the workers never allocate from the pools
+		size_t numParallelPoints = numPoints - firstParallelPoint;
+		size_t firstTriangle = trianglesPool.GetNewRange(2 * numParallelPoints);
+		size_t firstEdge = edgesPool.GetNewRange(6 * numParallelPoints);
+		size_t firstVertex = verticesPool.GetNewRange(numParallelPoints);
+
+		// one lock per triangle, which can use its slot in the pool as the pool does not grow until the workers are done
+		std::vector< std::atomic<bool> >(trianglesPool.NumUsed()).swap(triangleLocks);
+		Parallel::For(0, trianglesPool.NumUsed(), s_parallelMinBlockSize, [this](size_t i)
+		{
+			trianglesPool[i].lockSlot = (uint32_t)i;
+		});
+
+		std::vector<ParallelInsertionWorker> workers(Parallel::NumThreads());
+		for (auto& worker : workers)
+		{
+			worker.lastTriangle = lastTriangle;
+		}
+
+		size_t batchBegin = firstParallelPoint;
+		for (size_t batchSize = firstParallelPoint; batchBegin < numPoints; batchSize *= 2)
+		{
+			size_t batchEnd = std::min(numPoints, batchBegin + batchSize);
+
+			Parallel::ForBlocks(batchBegin, batchEnd, s_parallelMinBlockSize, [&](size_t blockBegin, size_t blockEnd, size_t block)
+			{
+				ParallelInsertionWorker& worker = workers[block];
+
+				for (size_t i = blockBegin; i < blockEnd; i++)
+				{
+					size_t slot = i - firstParallelPoint;
+
+					DelaunayVertex* vertex = &verticesPool[firstVertex + slot];
+					vertex->Clear();
+					vertex->v = QuantizePosition(points[insertionIndices[i]]);
+
+					DelaunayTriangle* newTriangles[2];
+					for (size_t j = 0; j < 2; j++)
+					{
+						newTriangles[j] = &trianglesPool[firstTriangle + 2 * slot + j];
+						newTriangles[j]->Clear();
+					}
+
+					DelaunayEdge* newEdges[6];
+					for (size_t j = 0; j < 6; j++)
+					{
+						newEdges[j] = &edgesPool[firstEdge + 6 * slot + j];
+						newEdges[j]->Clear();
+					}
+
+					for (int attempt = 0; ; attempt++)
+					{
+						if (TryAddPointToTriangulationConcurrently(worker, vertex, newTriangles, newEdges) != ParallelInsertionResult::CONFLICT)
+						{
+							break;
+						}
+						Parallel::BackOff(attempt);
+					}
+				}
+			});
+
+			batchBegin = batchEnd;
+		}
+
+		lastTriangle = workers[0].lastTriangle;
+		for (auto& worker : workers)
+		{
+			stats.Add(worker.stats);
+		}
+
+		triangleLocks = std::vector< std::atomic<bool> >();
+
+		// the workers only set the edge of the vertices they add, so the rest may have lost it to the cavities
+		for (size_t i = 0; i < trianglesPool.NumUsed(); i++)
+		{
+			DelaunayTriangle& triangle = trianglesPool[i];
+			if (triangle.edge && triangle.IsLeaf())
+			{
+				DelaunayEdge* edge = triangle.edge;
+				for (int j = 0; j < 3; j++, edge = edge->next)
+				{
+					edge->v->edge = edge;
+				}
+			}
+		}
+	}
+
+	// Try to add the point of the vertex to the triangulation while other workers do the same (Bowyer-Watson insertion):
+	// the triangles whose circumcircle contains the point (the cavity) are replaced by a fan of triangles around it.
+	//
+	// A worker only reads or changes a triangle, its half-edges and the face of their twins while holding its lock. The
+	// worker locks the cavity and the triangles around it before changing anything, and when one of them is held by
+	// another worker it unlocks everything and reports the conflict, so the insertion is tried again later
+	ParallelInsertionResult TryAddPointToTriangulationConcurrently(ParallelInsertionWorker& worker, DelaunayVertex* vertex, DelaunayTriangle** newTriangles, DelaunayEdge** newEdges)
+	{
+		const glm::vec3& point = vertex->v;
+
+		worker.cavity.clear();
+		worker.ring.clear();
+
+		DelaunayTriangle* triangle = nullptr;
+		if (!LockedWalkToTriangleWhereToAddPoint(point, worker.lastTriangle, triangle, worker.stats))
+		{
+			return ParallelInsertionResult::CONFLICT;
+		}
+
+		if (!triangle)
+		{
+			// no triangle found
+			DELAUNAY_STATS_COUNT(worker.stats.failedLocations, 1);
+			return ParallelInsertionResult::SKIPPED;
+		}
+
+		worker.cavity.push_back(triangle);
+
+		// a point that is already in the triangulation is not added again
+		if (IsPointInTriangleVertex(triangle, point))
+		{
+			UnlockParallelInsertionTriangles(worker);
+			return ParallelInsertionResult::SKIPPED;
+		}
+
+		// grow the cavity across its edges, locking every triangle reached
+		for (size_t i = 0; i < worker.cavity.size(); i++)
+		{
+			DelaunayEdge* edge = worker.cavity[i]->edge;
+			for (int j = 0; j < 3; j++, edge = edge->next)
+			{
+				if (!edge->twin)
+				{
+					continue;
+				}
+
+				DelaunayTriangle* neighbour = edge->twin->face;
+				if (std::find(worker.cavity.begin(), worker.cavity.end(), neighbour) != worker.cavity.end())
+				{
+					continue;
+				}
+
+				auto ringTriangle = std::find(worker.ring.begin(), worker.ring.end(), neighbour);
+				bool inRing = ringTriangle != worker.ring.end();
+				if (!inRing && !TryLockTriangle(neighbour))
+				{
+					UnlockParallelInsertionTriangles(worker);
+					return ParallelInsertionResult::CONFLICT;
+				}
+
+				DELAUNAY_STATS_COUNT(worker.stats.inCircleTests, 1);
+				if (IsNeighbourInCavity(edge, vertex))
+				{
+					if (inRing)
+					{
+						worker.ring.erase(ringTriangle);
+					}
+					worker.cavity.push_back(neighbour);
+				}
+				else if (!inRing)
+				{
+					worker.ring.push_back(neighbour);
+				}
+			}
+		}
+
+		// the cavity boundary edges are kept (so the twins beyond the cavity stay as they are), and the rest of the cavity
+		// edges and triangles are reused for the fan
+		worker.boundary.clear();
+		worker.boundaryEnds.clear();
+		worker.spareEdges.clear();
+		worker.spareTriangles.clear();
+
+		for (auto cavityTriangle : worker.cavity)
+		{
+			DelaunayEdge* edge = cavityTriangle->edge;
+			for (int j = 0; j < 3; j++, edge = edge->next)
+			{
+				if (!edge->twin || std::find(worker.cavity.begin(), worker.cavity.end(), edge->twin->face) == worker.cavity.end())
+				{
+					worker.boundary.push_back(edge);
+					worker.boundaryEnds.push_back(edge->next->v);
+				}
+				else
+				{
+					worker.spareEdges.push_back(edge);
+				}
+			}
+
+			worker.spareTriangles.push_back(cavityTriangle);
+		}
+
+		worker.spareEdges.insert(worker.spareEdges.end(), newEdges, newEdges + 6);
+		for (int j = 0; j < 2; j++)
+		{
+			TryLockTriangle(newTriangles[j]);
+			worker.spareTriangles.push_back(newTriangles[j]);
+		}
+
+		size_t numBoundaryEdges = worker.boundary.size();
+		assert(numBoundaryEdges == worker.spareTriangles.size());
+
+		// fan triangle (a, b, p) for every boundary edge (a, b)
+		for (size_t i = 0; i < numBoundaryEdges; i++)
+		{
+			DelaunayEdge* edgeA = worker.boundary[i];
+			DelaunayEdge* edgeB = worker.spareEdges[2 * i];
+			DelaunayEdge* edgeC = worker.spareEdges[2 * i + 1];
+			DelaunayTriangle* fanTriangle = worker.spareTriangles[i];
+
+			fanTriangle->edge = edgeA;
+			edgeA->face = edgeB->face = edgeC->face = fanTriangle;
+
+			SetEdgesOrderRelationship(edgeA, edgeB, edgeC);
+			SetEdgesVertexRelationship(edgeB, worker.boundaryEnds[i]);
+			SetEdgesVertexRelationship(edgeC, vertex);
+		}
+
+		// (b, p) is the twin of the (p, b) of the fan triangle whose boundary edge starts at b
+		for (size_t i = 0; i < numBoundaryEdges; i++)
+		{
+			for (size_t j = 0; j < numBoundaryEdges; j++)
+			{
+				if (worker.boundary[j]->v == worker.boundaryEnds[i])
+				{
+					SetEdgesTwinRelationship(worker.boundary[i]->next, worker.boundary[j]->next->next);
+					break;
+				}
+			}
+		}
+
+		vertex->edge = worker.boundary[0]->next->next;
+		worker.lastTriangle = worker.spareTriangles[0];
+
+		UnlockParallelInsertionTriangles(worker);
+		UnlockTriangle(newTriangles[0]);
+		UnlockTriangle(newTriangles[1]);
+
+		return ParallelInsertionResult::INSERTED;
+	}
+
+	// Walk to the triangle where to add the point (as WalkToTriangleWhereToAddPoint) locking the triangles hand over hand.
+	// Returns false, with nothing locked, when another worker holds a triangle on the way. Otherwise the triangle found is
+	// left locked (nullptr when the point is outside the root triangle). The steps go to the statistics of the worker
+	bool LockedWalkToTriangleWhereToAddPoint(const glm::vec3& point, DelaunayTriangle* start, DelaunayTriangle*& triangle, DelaunayStats& workerStats)
+	{
+		triangle = start;
+		if (!TryLockTriangle(triangle))
+		{
+			return false;
+		}
+
+		DelaunayEdge* entryEdge = nullptr;
+
+		for (size_t step = 0; step < trianglesPool.NumUsed(); step++)
+		{
+			DelaunayEdge* exitEdge = nullptr;
+			DELAUNAY_STATS_COUNT(workerStats.locationSteps, 1);
+
+			DelaunayEdge* edge = triangle->edge;
+			for (int i = 0; i < 3; i++, edge = edge->next)
+			{
+				if (edge != entryEdge && Orient2D(edge->v->v, edge->next->v->v, point) > 0.0)
+				{
+					exitEdge = edge;
+					break;
+				}
+			}
+
+			if (!exitEdge)
+			{
+				return true;
+			}
+
+			if (!exitEdge->twin)
+			{
+				UnlockTriangle(triangle);
+				triangle = nullptr;
+				return true;
+			}
+
+			DelaunayTriangle* next = exitEdge->twin->face;
+			if (!TryLockTriangle(next))
+			{
+				UnlockTriangle(triangle);
+				return false;
+			}
+
+			entryEdge = exitEdge->twin;
+			UnlockTriangle(triangle);
+			triangle = next;
+		}
+
+		// the triangulation kept changing under the walk
+		UnlockTriangle(triangle);
+		return false;
+	}
+
+	// Is the triangle beyond the edge of the cavity part of the cavity of the vertex. It is when the edge would be flipped
+	// after adding the vertex to the cavity triangle (which is what the sequential insertion does), or when the vertex is
+	// not strictly inside the cavity side of the edge (the fan triangle of the edge would be degenerate)
+	bool IsNeighbourInCavity(const DelaunayEdge* edge, const DelaunayVertex* vertex)
+	{
+		const DelaunayVertex* vertexI = edge->v;
+		const DelaunayVertex* vertexJ = edge->next->v;
+		const DelaunayVertex* vertexL = edge->twin->next->next->v;
+
+		if (Orient2D(vertexI->v, vertexJ->v, vertex->v) >= 0.0)
+		{
+			return true;
+		}
+
+		return IsDelaunayEdgeIllegal(vertexI, vertexJ, vertex, vertexL);
+	}
+
+	// Try to lock the triangle during the parallel insertion (never waits)
+	bool TryLockTriangle(DelaunayTriangle* triangle)
+	{
+		std::atomic<bool>& lock = triangleLocks[triangle->lockSlot];
+		return !lock.load(std::memory_order_relaxed) && !lock.exchange(true, std::memory_order_acquire);
+	}
+
+	// Unlock the triangle
+	void UnlockTriangle(DelaunayTriangle* triangle)
+	{
+		triangleLocks[triangle->lockSlot].store(false, std::memory_order_release);
+	}
+
+	// Unlock the triangles held by the worker (the cavity and the triangles around it)
+	void UnlockParallelInsertionTriangles(ParallelInsertionWorker& worker)
+	{
+		for (auto triangle : worker.cavity)
+		{
+			UnlockTriangle(triangle);
+		}
+
+		for (auto triangle : worker.ring)
+		{
+			UnlockTriangle(triangle);
+		}
+	}
+
+	// Locate the triangle that contains the point
+	DelaunayTriangle* LocateTriangle(const glm::vec3& point)
+	{
+		if (pointLocation == DelaunayPointLocation::WALK)
+		{
+			// the flips are done in place while walking, so there is no complete history DAG to fall back to
+			DelaunayTriangle* triangle = lastTriangle ? WalkToTriangleWhereToAddPoint(point, lastTriangle) : nullptr;
+			if (!triangle && streaming)
+			{
+				triangle = LocateStreamTriangle(point);
+			}
+
+			return triangle;
+		}
+
+		return GetTriangleWhereToAddPoint(point, rootTriangle);
+	}
+
+	// Walk to triangle where to add point
+	DelaunayTriangle* WalkToTriangleWhereToAddPoint(const glm::vec3& point, DelaunayTriangle* triangle)
+	{
+		// Triangles are stored clockwise in the xz plane, so the point is beyond an edge when it lies counter-clockwise of it.
+		// The edge we entered from is never tested again, which keeps the walk from bouncing between two triangles
+		DelaunayEdge* entryEdge = nullptr;
+
+		for (size_t step = 0; step < trianglesPool.NumUsed(); step++)
+		{
+			DelaunayEdge* exitEdge = nullptr;
+			DELAUNAY_STATS_COUNT(stats.locationSteps, 1);
+
+			DelaunayEdge* edge = triangle->edge;
+			for (int i = 0; i < 3; i++, edge = edge->next)
+			{
+				if (edge != entryEdge && Orient2D(edge->v->v, edge->next->v->v, point) > 0.0)
+				{
+					exitEdge = edge;
+					break;
+				}
+			}
+
+			if (!exitEdge)
+			{
+				// the point is inside or on the boundary of this triangle
+				return triangle;
+			}
+
+			if (!exitEdge->twin)
+			{
+				// the point is outside the root triangle
+				return nullptr;
+			}
+
+			// step into the adjacent triangle
+			entryEdge = exitEdge->twin;
+			triangle = entryEdge->face;
+		}
+
+		return nullptr;
+	}
+
+	// Get Triangle where to add point
+	DelaunayTriangle* GetTriangleWhereToAddPoint(const glm::vec3& point, DelaunayTriangle* triangle)
+	{	
+		DELAUNAY_STATS_COUNT(stats.locationSteps, 1);
+
+		const glm::vec3& v1 = triangle->edge->v->v;
+		const glm::vec3& v2 = triangle->edge->next->v->v;
+		const glm::vec3& v3 = triangle->edge->next->next->v->v;
+
+		// Point in triangle test to check the triangle that contains the point to be added
+		if (Geom2DTest::PointInTriangle(point, v1, v2, v3))
+		{
+			if (triangle->IsLeaf())
+			{
+				// Leaf... so return this one
+				return triangle;
+			}
+			else
+			{
+				// recursively check which of the children contains the point
+				for (int i = 0; i < triangle->numChildren; i++)
+				{
+					DelaunayTriangle* child = GetTriangleWhereToAddPoint(point, triangle->children[i]);
+					if (child)
+					{
+						return child;
+					}
+				}
+			}
+		}
+
+		return nullptr;
+	}
+
+	// Is Point In Triangle Vertex
+	bool IsPointInTriangleVertex(DelaunayTriangle* triangle, const glm::vec3& point)
+	{
+		return GetTriangleVertexWithPoint(triangle, point) != nullptr;
+	}
+
+	// Get the vertex of the triangle at the point (nullptr if the point is not at any of them)
+	DelaunayVertex* GetTriangleVertexWithPoint(DelaunayTriangle* triangle, const glm::vec3& point)
+	{
+		DelaunayEdge* edge = triangle->edge;
+		for (int i = 0; i < 3; i++, edge = edge->next)
+		{
+			if (edge->v->v.x == point.x && edge->v->v.z == point.z)
+			{
+				return edge->v;
+			}
+		}
+
+		return nullptr;
+	}
+
+	// Get the edge of the triangle in which the point lies (nullptr if the point does not lie in any edge)
+	DelaunayEdge* GetTriangleEdgeWithPoint(DelaunayTriangle* triangle, const glm::vec3& point)
+	{
+		// Point in segment test to check if the points lies in any of the edges of the triangle
+		DelaunayEdge* edge = triangle->edge;
+		for (int i = 0; i < 3; i++, edge = edge->next)
+		{
+			if (Geom2DTest::PointInLineSegment(point, edge->v->v, edge->next->v->v))
 			{
-				// recursively check which of the children contains the point
-				auto& children = triangle->children;
-				for (size_t i = 0; i < children.size(); i++)
-				{
-					DelaunayTriangle* child = GetTriangleWhereToAddPoint(point, children[i]);
-					if (child)
-					{
-						return child;
-					}
-				}
+				return edge;
 			}
 		}
 
 		return nullptr;
 	}
 
-	// Is Point In Triangle Edge
-	bool IsPointInTriangleEdge(DelaunayTriangle* triangle, const glm::vec3& point)
+	// Split Adjacent Triangles, returning the vertex of the point
+	DelaunayVertex* SplitAdjacentTriangles(DelaunayEdge* edge, const glm::vec3& point)
 	{
-		const glm::vec3& v1 = triangle->edge->v->v;
-		const glm::vec3& v2 = triangle->edge->next->v->v;
-		const glm::vec3& v3 = triangle->edge->next->next->v->v;
+		// The point lies in the edge (i, j) shared by the triangles (i, j, k) and (j, i, l). Each of them is split in
+		// two at the point, giving the children (i, p, k), (p, j, k), (j, p, l) and (p, i, l)
+		DelaunayEdge* twin = edge->twin;
 
-		// Point in segment test to check if the points lies in any of the edges of the triangle
-		if (	Geom2DTest::PointInLineSegment(point, v1, v2)
-			||	Geom2DTest::PointInLineSegment(point, v2, v3)
-			||	Geom2DTest::PointInLineSegment(point, v3, v1))
+		// get new vertex
+		DelaunayVertex* vertex = GetNewDelaunayVertex();
+		vertex->v = point;
+
+		DelaunayTriangle* childA = nullptr;
+		DelaunayTriangle* childB = nullptr;
+		SplitTriangleAtEdge(edge, vertex, childA, childB);
+
+		DelaunayTriangle* childC = nullptr;
+		DelaunayTriangle* childD = nullptr;
+		if (twin)
 		{
-			return true;
+			SplitTriangleAtEdge(twin, vertex, childC, childD);
+
+			// the halves of the split edge: (i, p) with (p, i) and (p, j) with (j, p)
+			SetEdgesTwinRelationship(childA->edge, childD->edge);
+			SetEdgesTwinRelationship(childB->edge, childC->edge);
 		}
 
-		return false;
+		lastTriangle = childA;
+
+		// Legalize edges
+		edgesToLegalize.push_back(childA->edge->next->next);
+		edgesToLegalize.push_back(childB->edge->next);
+		if (twin)
+		{
+			edgesToLegalize.push_back(childC->edge->next->next);
+			edgesToLegalize.push_back(childD->edge->next);
+		}
+		LegalizeEdges();
+
+		return vertex;
+	}
+
+	// Split the triangle (i, j, k) of the edge (i, j) at the vertex p lying in that edge, into (i, p, k) and (p, j, k).
+	// The first edge of each child is its half of the split edge, whose twin is left for the caller to set
+	void SplitTriangleAtEdge(DelaunayEdge* edge, DelaunayVertex* vertex, DelaunayTriangle*& childA, DelaunayTriangle*& childB)
+	{
+		DelaunayTriangle* parent = edge->face;
+
+		DelaunayVertex* vertexI = edge->v;
+		DelaunayVertex* vertexJ = edge->next->v;
+		DelaunayVertex* vertexK = edge->next->next->v;
+
+		childA = GetNewDelaunayTriangle(vertexI, vertex, vertexK);
+		childB = GetNewDelaunayTriangle(vertex, vertexJ, vertexK);
+
+		// half-edge twins: (p, k) with (k, p) and the outer edges with the ones of the parent
+		SetEdgesTwinRelationship(childA->edge->next, childB->edge->next->next);
+		SetEdgesTwinRelationship(childA->edge->next->next, edge->next->next->twin);
+		SetEdgesTwinRelationship(childB->edge->next, edge->next->twin);
+
+		// the halves of a breakline edge, and the outer edges, keep their constraint
+		childA->edge->constrained = childB->edge->constrained = edge->constrained;
+		childA->edge->next->next->constrained = edge->next->next->constrained;
+		childB->edge->next->constrained = edge->next->constrained;
+
+		// the vertices get edges of the children (the ones of the parent are no longer part of the triangulation)
+		vertex->edge = childA->edge->next;
+		vertexI->edge = childA->edge;
+		vertexJ->edge = childB->edge->next;
+		vertexK->edge = childA->edge->next->next;
+
+		// set parent-child relationship
+		SetParentChildRelationship(parent, childA);
+		SetParentChildRelationship(parent, childB);
 	}
 
-	// Split Adjacent Triangles
-	void SplitAdjacentTriangles(DelaunayTriangle* triangle, const glm::vec3& point)
+	// Get a new DelaunayTriangle (a, b, c) with its half-edges, starting with the edge (a, b). The twins are left unset
+	DelaunayTriangle* GetNewDelaunayTriangle(DelaunayVertex* vertexA, DelaunayVertex* vertexB, DelaunayVertex* vertexC)
 	{
-		// TO-DO
-		printf("TO-DO: Delaunay::SplitAdjacentTriangles\n");
+		DelaunayTriangle* triangle = GetNewDelaunayTriangle();
+
+		// get new half-edges
+		DelaunayEdge* edgeA = GetNewDelaunayEdge();
+		DelaunayEdge* edgeB = GetNewDelaunayEdge();
+		DelaunayEdge* edgeC = GetNewDelaunayEdge();
+
+		// face edge
+		triangle->edge = edgeA;
+
+		// half-edge faces
+		edgeA->face = edgeB->face = edgeC->face = triangle;
+
+		// half-edge order
+		SetEdgesOrderRelationship(edgeA, edgeB, edgeC);
+
+		// half-edge start vertex
+		SetEdgesVertexRelationship(edgeA, vertexA);
+		SetEdgesVertexRelationship(edgeB, vertexB);
+		SetEdgesVertexRelationship(edgeC, vertexC);
+
+		return triangle;
 	}
 
-	// Split Triangle
-	void SplitTriangle(DelaunayTriangle* triangle, const glm::vec3& point)
+	// Split Triangle, returning the vertex of the point
+	DelaunayVertex* SplitTriangle(DelaunayTriangle* triangle, const glm::vec3& point)
 	{
 		// get 3 new DelaunayTriangle
 		DelaunayTriangle* childA = GetNewDelaunayTriangle();
 		DelaunayTriangle* childB = GetNewDelaunayTriangle();
 		DelaunayTriangle* childC = GetNewDelaunayTriangle();
 
-		// set children
-		childA->v1 = point;
-		childA->v2 = triangle->v1;
-		childA->v3 = triangle->v2;
-
-		childB->v1 = point;
-		childB->v2 = triangle->v2;
-		childB->v3 = triangle->v3;
-
-		childC->v1 = point;
-		childC->v2 = triangle->v3;
-		childC->v3 = triangle->v1;
-
 		// update adjacency information
 		UpdateAdjacencyInformation(triangle, childA, childB, childC, point);
 
@@ -381,10 +3189,16 @@ private:
 		SetParentChildRelationship(triangle, childB);
 		SetParentChildRelationship(triangle, childC);
 
-		// Legalize edges
-		LegalizeEdges(point, childA);
-		LegalizeEdges(point, childB);
-		LegalizeEdges(point, childC);
+		lastTriangle = childC;
+
+		// Legalize edges (the first edge of every child is the one opposite to the point)
+		edgesToLegalize.push_back(childA->edge);
+		edgesToLegalize.push_back(childB->edge);
+		edgesToLegalize.push_back(childC->edge);
+		LegalizeEdges();
+
+		// the last edge of every child starts at the point
+		return childA->edge->next->next->v;
 	}
 
 	// Update Adjacency Information
@@ -426,6 +3240,11 @@ private:
 		SetEdgesTwinRelationship(childA_edgeA, childA_edgeA->twin);
 		SetEdgesTwinRelationship(childB_edgeA, childB_edgeA->twin);
 		SetEdgesTwinRelationship(childC_edgeA, childC_edgeA->twin);
+
+		// the outer edges keep the constraint of the ones of the parent
+		childA_edgeA->constrained = parent->edge->constrained;
+		childB_edgeA->constrained = parent->edge->next->constrained;
+		childC_edgeA->constrained = parent->edge->next->next->constrained;
 		SetEdgesTwinRelationship(childA_edgeB, childB_edgeC);
 		SetEdgesTwinRelationship(childA_edgeC, childC_edgeB);
 		SetEdgesTwinRelationship(childB_edgeB, childC_edgeC);
@@ -445,13 +3264,23 @@ private:
 		SetEdgesVertexRelationship(childC_edgeA, parent->edge->next->next->v);
 		SetEdgesVertexRelationship(childC_edgeB, parent->edge->v);
 		SetEdgesVertexRelationship(childC_edgeC, vertex);
+
+		// the vertices of the parent get edges of the children
+		childA_edgeA->v->edge = childA_edgeA;
+		childB_edgeA->v->edge = childB_edgeA;
+		childC_edgeA->v->edge = childC_edgeA;
 	}
 
 	// Set parent-child relationship
 	void SetParentChildRelationship(DelaunayTriangle* parent, DelaunayTriangle* child)
 	{
-		parent->children.push_back(child);
+		parent->AddChild(child);
 		child->parent = parent;
+
+		if (trackTouchedTriangles)
+		{
+			touchedTriangles.push_back(parent);
+		}
 	}
 
 	// Set edges order relationship
@@ -476,60 +3305,140 @@ private:
 	}
 
 	// Legalize edges
-	void LegalizeEdges(const glm::vec3& point, DelaunayTriangle* triangle)
+	void LegalizeEdges()
 	{
-		// find the edge to legalize
-		DelaunayEdge* edge = nullptr; 
-		if (triangle->edge->next->next->v->v == point)
-		{
-			edge = triangle->edge;
-		}
-		else if (triangle->edge->v->v == point)
+		DELAUNAY_STATS_TIMER(stats.legalizationTime);
+
+		// Every pending edge is opposite to the point just added. Flipping an illegal one exposes the two edges beyond it,
+		// which are pushed in turn, so the cascade runs on the work stack instead of recursing once per flip
+		while (!edgesToLegalize.empty())
 		{
-			edge = triangle->edge->next;
+			DelaunayEdge* edge = edgesToLegalize.back();
+			edgesToLegalize.pop_back();
+
+			if (IsDelaunayEdgeIllegal(edge))
+			{
+				// flip edge
+				if (pointLocation == DelaunayPointLocation::HISTORY_DAG)
+				{
+					FlipEdgeWithHistory(edge);
+				}
+				else
+				{
+					FlipEdge(edge);
+				}
+			}
 		}
-		else if (triangle->edge->next->v->v == point)
+	}
+
+	// Legalize edges anywhere in the triangulation (not only the ones opposite to a point just added): flipping an illegal
+	// edge exposes the four edges around it
+	void LegalizeAllEdges()
+	{
+		DELAUNAY_STATS_TIMER(stats.legalizationTime);
+
+		while (!edgesToLegalize.empty())
 		{
-			edge = triangle->edge->next->next;
+			DelaunayEdge* edge = edgesToLegalize.back();
+			edgesToLegalize.pop_back();
+
+			if (IsDelaunayEdgeIllegal(edge))
+			{
+				// the flip pushes the edges beyond the new one on the side of the vertex of the flipped edge
+				FlipEdge(edge);
+
+				edgesToLegalize.push_back(edge->next);
+				edgesToLegalize.push_back(edge->twin->next->next);
+			}
 		}
-		assert(edge);
-		
-		if (IsDelaunayEdgeIllegal(edge))
+	}
+
+	// Flip edge
+	void FlipEdge(DelaunayEdge* edge)
+	{
+		DELAUNAY_STATS_COUNT(stats.flips, 1);
+
+		// The edge (i, j) shared by the triangles (i, j, k) and (j, i, l) becomes the edge (l, k) shared by (k, i, l) and
+		// (l, j, k). Both triangles and all their half-edges are rewired in place, so the flip allocates nothing
+		DelaunayEdge* twin = edge->twin;
+
+		DelaunayTriangle* triangleA = edge->face;
+		DelaunayTriangle* triangleB = twin->face;
+
+		DelaunayEdge* edgeJK = edge->next;
+		DelaunayEdge* edgeKI = edgeJK->next;
+		DelaunayEdge* edgeIL = twin->next;
+		DelaunayEdge* edgeLJ = edgeIL->next;
+
+		DelaunayVertex* vertexI = edge->v;
+		DelaunayVertex* vertexJ = twin->v;
+		DelaunayVertex* vertexK = edgeKI->v;
+		DelaunayVertex* vertexL = edgeLJ->v;
+
+		// (k, i, l)
+		SetEdgesOrderRelationship(edgeKI, edgeIL, edge);
+		SetEdgesVertexRelationship(edge, vertexL);
+		edgeIL->face = triangleA;
+		triangleA->edge = edgeKI;
+
+		// (l, j, k)
+		SetEdgesOrderRelationship(edgeLJ, edgeJK, twin);
+		SetEdgesVertexRelationship(twin, vertexK);
+		edgeJK->face = triangleB;
+		triangleB->edge = edgeLJ;
+
+		// i and j lost the flipped edge, so make sure their edges are still outgoing ones
+		vertexI->edge = edgeIL;
+		vertexJ->edge = edgeJK;
+		vertexK->edge = edgeKI;
+		vertexL->edge = edgeLJ;
+
+		if (trackTouchedTriangles)
 		{
-			// flip edge
-			FlipEdge(point, edge);
+			touchedTriangles.push_back(triangleA);
+			touchedTriangles.push_back(triangleB);
 		}
+
+		// the edges beyond the flipped one are now opposite to the point
+		edgesToLegalize.push_back(edgeIL);
+		edgesToLegalize.push_back(edgeLJ);
 	}
 
-	// Flip edge
-	void FlipEdge(const glm::vec3& point, DelaunayEdge* edge)
+	// Flip edge keeping the history: the two triangles become parents of the two new ones in the history DAG
+	void FlipEdgeWithHistory(DelaunayEdge* edge)
 	{
-		// Flip the edge by creating new triangles and edges and updating adjacency information
+		DELAUNAY_STATS_COUNT(stats.flips, 1);
 
-		// current state
-		DelaunayEdge* edgeTwin = edge->twin;
+		DelaunayEdge* twin = edge->twin;
 
 		DelaunayTriangle* triangleA = edge->face;
-		DelaunayTriangle* triangleB = edge->twin->face;
+		DelaunayTriangle* triangleB = twin->face;
+
+		DelaunayEdge* edgeJK = edge->next;
+		DelaunayEdge* edgeKI = edgeJK->next;
+		DelaunayEdge* edgeIL = twin->next;
+		DelaunayEdge* edgeLJ = edgeIL->next;
 
-		DelaunayVertex* triangleA_vertexI = edge->v;
-		DelaunayVertex* triangleA_vertexJ = edge->next->v;
-		DelaunayVertex* triangleA_vertexK = edge->next->next->v;
+		DelaunayVertex* vertexI = edge->v;
+		DelaunayVertex* vertexJ = twin->v;
+		DelaunayVertex* vertexK = edgeKI->v;
+		DelaunayVertex* vertexL = edgeLJ->v;
 
-		DelaunayVertex* triangleB_vertexI = edgeTwin->v;
-		DelaunayVertex* triangleB_vertexJ = edgeTwin->next->v;
-		DelaunayVertex* triangleB_vertexK = edgeTwin->next->next->v;
+		// create two new triangles: (k, i, l) and (l, j, k)
+		DelaunayTriangle* newTriangleA = GetNewDelaunayTriangle(vertexK, vertexI, vertexL);
+		DelaunayTriangle* newTriangleB = GetNewDelaunayTriangle(vertexL, vertexJ, vertexK);
 
-		// create two new triangles
-		DelaunayTriangle* newTriangleA = GetNewDelaunayTriangle();
-		newTriangleA->v1 = triangleA_vertexK->v;
-		newTriangleA->v2 = triangleA_vertexI->v;
-		newTriangleA->v2 = triangleA_vertexK->v;
+		// set twin relationship
+		SetEdgesTwinRelationship(newTriangleA->edge, edgeKI->twin);
+		SetEdgesTwinRelationship(newTriangleA->edge->next, edgeIL->twin);
+		SetEdgesTwinRelationship(newTriangleB->edge, edgeLJ->twin);
+		SetEdgesTwinRelationship(newTriangleB->edge->next, edgeJK->twin);
+		SetEdgesTwinRelationship(newTriangleA->edge->next->next, newTriangleB->edge->next->next);
 
-		DelaunayTriangle* newTriangleB = GetNewDelaunayTriangle();
-		newTriangleA->v1 = triangleB_vertexK->v;
-		newTriangleA->v2 = triangleA_vertexI->v;
-		newTriangleA->v2 = triangleB_vertexK->v;
+		vertexI->edge = newTriangleA->edge->next;
+		vertexJ->edge = newTriangleB->edge->next;
+		vertexK->edge = newTriangleA->edge;
+		vertexL->edge = newTriangleB->edge;
 
 		// set parent-child relationship
 		SetParentChildRelationship(triangleA, newTriangleA);
@@ -537,123 +3446,391 @@ private:
 		SetParentChildRelationship(triangleB, newTriangleA);
 		SetParentChildRelationship(triangleB, newTriangleB);
 
-		// create new edges
-		DelaunayEdge* triangleA_newEdgeA = GetNewDelaunayEdge();
-		DelaunayEdge* triangleA_newEdgeB = GetNewDelaunayEdge();
-		DelaunayEdge* triangleA_newEdgeC = GetNewDelaunayEdge();
+		lastTriangle = newTriangleB;
+
+		// the edges beyond the flipped one are now opposite to the point
+		edgesToLegalize.push_back(newTriangleA->edge->next);
+		edgesToLegalize.push_back(newTriangleB->edge);
+	}
+
+	// Is DelaunayEdge Illegeal
+	bool IsDelaunayEdgeIllegal(DelaunayEdge* edge)
+	{
+		DelaunayEdge* twin = edge->twin;
+		if (!twin || edge->constrained)
+		{
+			// the edge is not shared at all (or it is part of a breakline) so no way to flip it
+			return false;
+		}
 
-		DelaunayEdge* triangleB_newEdgeA = GetNewDelaunayEdge();
-		DelaunayEdge* triangleB_newEdgeB = GetNewDelaunayEdge();
-		DelaunayEdge* triangleB_newEdgeC = GetNewDelaunayEdge();
+		DELAUNAY_STATS_COUNT(stats.inCircleTests, 1);
+		return IsDelaunayEdgeIllegal(edge->v, edge->next->v, edge->next->next->v, twin->next->next->v);
+	}
 
-		// set twin relationship
-		SetEdgesTwinRelationship(triangleA_newEdgeA, edge->next->next->twin);
-		SetEdgesTwinRelationship(triangleA_newEdgeB, edgeTwin->next->twin);
-		SetEdgesTwinRelationship(triangleB_newEdgeA, edgeTwin->next->next->twin);
-		SetEdgesTwinRelationship(triangleB_newEdgeB, edge->next->twin);
-		SetEdgesTwinRelationship(triangleA_newEdgeC, triangleB_newEdgeC);
+	// Is the edge (i, j) of the triangle (i, j, k), shared with the triangle (j, i, l), illegal
+	bool IsDelaunayEdgeIllegal(const DelaunayVertex* vertexI, const DelaunayVertex* vertexJ, const DelaunayVertex* vertexK, const DelaunayVertex* vertexL)
+	{
+		if (IsRootVertex(vertexI) || IsRootVertex(vertexJ) || IsRootVertex(vertexK) || IsRootVertex(vertexL))
+		{
+			return !keepConvexHull && IsRootEdgeIllegal(vertexI, vertexJ, vertexK, vertexL);
+		}
+
+		// the triangles are clockwise, so (i, k, j) is the counter-clockwise order the in circle test expects
+		return InCircle(vertexI->v, vertexK->v, vertexJ->v, vertexL->v) > 0.0;
+	}
+
+	// Is the edge (i, j) of the triangle (i, j, k), opposite to l, illegal when root vertices are involved.
+	// The root vertices are treated as if they were infinitely far away: the circumcircle of a triangle with one root
+	// vertex becomes the open half-plane bounded by its real edge on the side of the root vertex, and no real triangle
+	// circumcircle contains a root vertex. This keeps the size of the root triangle out of the result
+	bool IsRootEdgeIllegal(const DelaunayVertex* vertexI, const DelaunayVertex* vertexJ, const DelaunayVertex* vertexK, const DelaunayVertex* vertexL)
+	{
+		bool rootI = IsRootVertex(vertexI);
+		bool rootJ = IsRootVertex(vertexJ);
+		if (rootI == rootJ)
+		{
+			// either an edge of the root triangle or a real edge, which is never flipped towards a root vertex
+			return false;
+		}
+
+		const DelaunayVertex* root = rootI ? vertexI : vertexJ;
+		const DelaunayVertex* real = rootI ? vertexJ : vertexI;
+
+		// use the side of the edge whose triangle has a single root vertex
+		double rootSide, otherSide;
+		if (!IsRootVertex(vertexK))
+		{
+			rootSide = Orient2D(real->v, vertexK->v, root->v);
+			otherSide = Orient2D(real->v, vertexK->v, vertexL->v);
+		}
+		else if (!IsRootVertex(vertexL))
+		{
+			rootSide = Orient2D(real->v, vertexL->v, root->v);
+			otherSide = Orient2D(real->v, vertexL->v, vertexK->v);
+		}
+		else
+		{
+			return false;
+		}
+
+		if (!((rootSide > 0.0 && otherSide > 0.0) || (rootSide < 0.0 && otherSide < 0.0)))
+		{
+			return false;
+		}
+
+		// the flip is only possible when i and j lie on different sides of the new edge (k, l)
+		double sideI = Orient2D(vertexK->v, vertexL->v, vertexI->v);
+		double sideJ = Orient2D(vertexK->v, vertexL->v, vertexJ->v);
+
+		return (sideI > 0.0 && sideJ < 0.0) || (sideI < 0.0 && sideJ > 0.0);
+	}
+
+	// Is root vertex
+	bool IsRootVertex(const DelaunayVertex* vertex) const
+	{
+		return vertex == rootVertices[0] || vertex == rootVertices[1] || vertex == rootVertices[2];
+	}
+
+	// Extract the final triangulation into the mesh, discarding the triangles that share any of the vertices of the root
+	// triangle. Every pass is linear over the pools and runs in parallel: the triangles and the vertices kept are numbered
+	// with a prefix sum over blocks, and then every triangle writes its own slots of the mesh
+	void ExtractTriangulationMesh()
+	{
+		DELAUNAY_STATS_TIMER(stats.extractionTime);
+
+		const size_t minBlockSize = 1 << 12;
+
+		triangulationMesh.Clear();
+		meshTriangles.resize(trianglesPool.NumUsed());
+
+		size_t numTriangles = Parallel::Compact(trianglesPool.NumUsed(), minBlockSize, [this](size_t i)
+		{
+			DelaunayTriangle& triangle = trianglesPool[i];
+			triangle.exportIndex = -1;
+
+			return IsTriangulationTriangle(&triangle);
+		},
+		[this](size_t i, size_t index)
+		{
+			trianglesPool[i].exportIndex = (int)index;
+			meshTriangles[index] = &trianglesPool[i];
+		});
+
+		meshTriangles.resize(numTriangles);
+
+		// vertices kept: the points added (a vertex without edge is a slot left unused by a duplicated point, or a free one)
+		meshVertices.resize(verticesPool.NumUsed());
+
+		size_t numVertices = Parallel::Compact(verticesPool.NumUsed(), minBlockSize, [this](size_t i)
+		{
+			DelaunayVertex& vertex = verticesPool[i];
+			vertex.exportIndex = -1;
+
+			return vertex.edge && !IsRootVertex(&vertex);
+		},
+		[this](size_t i, size_t index)
+		{
+			verticesPool[i].exportIndex = (int)index;
+			meshVertices[index] = &verticesPool[i];
+		});
+
+		meshVertices.resize(numVertices);
+
+		triangulationMesh.positions.resize(numVertices);
+		triangulationMesh.heights.resize(numVertices);
+		triangulationMesh.origins.resize(3 * numTriangles);
+		triangulationMesh.twins.resize(3 * numTriangles);
+
+		Parallel::For(0, verticesPool.NumUsed(), minBlockSize, [this](size_t i)
+		{
+			const DelaunayVertex& vertex = verticesPool[i];
+			if (vertex.exportIndex >= 0)
+			{
+				triangulationMesh.positions[vertex.exportIndex] = glm::vec2(vertex.v.x, vertex.v.z);
+				triangulationMesh.heights[vertex.exportIndex] = vertex.v.y;
+			}
+		});
+
+		Parallel::For(0, trianglesPool.NumUsed(), minBlockSize, [this](size_t i)
+		{
+			const DelaunayTriangle& triangle = trianglesPool[i];
+			if (triangle.exportIndex < 0)
+			{
+				return;
+			}
 
-		// set order relationship
-		SetEdgesOrderRelationship(triangleA_newEdgeA, triangleA_newEdgeB, triangleA_newEdgeC);
-		SetEdgesOrderRelationship(triangleB_newEdgeA, triangleB_newEdgeB, triangleB_newEdgeC);
+			// the twins in discarded triangles are left unset
+			const DelaunayEdge* edge = triangle.edge;
+			for (uint32_t j = 0; j < 3; j++, edge = edge->next)
+			{
+				uint32_t meshEdge = 3 * triangle.exportIndex + j;
 
-		// set faces
-		newTriangleA->edge = triangleA_newEdgeA;
-		newTriangleB->edge = triangleB_newEdgeA;
+				triangulationMesh.origins[meshEdge] = edge->v->exportIndex;
 
-		triangleA_newEdgeA->face = triangleA_newEdgeB->face = triangleA_newEdgeC->face = newTriangleA;
-		triangleB_newEdgeA->face = triangleB_newEdgeB->face = triangleB_newEdgeC->face = newTriangleB;
+				const DelaunayEdge* twin = edge->twin;
+				bool twinKept = twin && twin->face->exportIndex >= 0;
+				triangulationMesh.twins[meshEdge] = twinKept ? 3 * twin->face->exportIndex + EdgeSlot(twin) : DelaunayMesh::INVALID_INDEX;
+			}
+		});
 
-		// set vertex relationship
-		SetEdgesVertexRelationship(triangleA_newEdgeA, triangleA_vertexK);
-		SetEdgesVertexRelationship(triangleA_newEdgeB, triangleA_vertexI);
-		SetEdgesVertexRelationship(triangleA_newEdgeC, triangleB_vertexK);
-		SetEdgesVertexRelationship(triangleB_newEdgeA, triangleB_vertexK);
-		SetEdgesVertexRelationship(triangleB_newEdgeB, triangleB_vertexI);
-		SetEdgesVertexRelationship(triangleB_newEdgeC, triangleA_vertexK);
+		triangulationMesh.LinkTriangles();
+	}
 
-		// Legalize the edges of the new triangles
-		LegalizeEdges(point, newTriangleA);
-		LegalizeEdges(point, newTriangleB);
+	// Is the triangle part of the final triangulation: a leaf without root vertices (the triangles without edge are free,
+	// or slots of the parallel insertion left unused by duplicated points)
+	bool IsTriangulationTriangle(const DelaunayTriangle* triangle) const
+	{
+		return	triangle->edge && triangle->IsLeaf()
+			&&	!IsRootVertex(triangle->edge->v) && !IsRootVertex(triangle->edge->next->v) && !IsRootVertex(triangle->edge->next->next->v);
 	}
 
-	// Is DelaunayEdge Illegeal
-	bool IsDelaunayEdgeIllegal(DelaunayEdge* edge)
+	// Is the half-edge of the mesh part of a breakline (only a live triangulation has them)
+	bool IsConstrainedMeshEdge(uint32_t edge) const
 	{
-		DelaunayEdge* twin = edge->twin;
-		if (!twin)
+		if (!rootTriangle)
 		{
-			// the edge is not shared at all so no way to flip it
 			return false;
 		}
 
-		// get triangle circumcenter
-		float radius = 0.0f;
-		glm::vec3 center;
+		const DelaunayEdge* triangleEdge = meshTriangles[edge / 3]->edge;
+		for (uint32_t j = 0; j < edge % 3; j++)
+		{
+			triangleEdge = triangleEdge->next;
+		}
+
+		return triangleEdge->constrained;
+	}
+
+	// Does the vertex start a half-edge of a leaf of the live triangulation
+	bool IsLiveVertex(const DelaunayVertex* vertex) const
+	{
+		return vertex->edge && vertex->edge->v == vertex && IsLiveTriangle(vertex->edge->face);
+	}
+
+	// Add the triangles around the vertex that have no export index to the outer triangles of the snapshot, numbering them
+	// after the ones of the mesh. The vertex may lie on the boundary, so the triangles are visited both ways from its edge
+	void AddSnapshotOuterTriangles(const DelaunayVertex* vertex, std::vector<DelaunayTriangle*>& outerTriangles)
+	{
+		auto addTriangle = [this, &outerTriangles](DelaunayTriangle* triangle)
+		{
+			if (triangle->exportIndex < 0)
+			{
+				triangle->exportIndex = (int)(triangulationMesh.NumTriangles() + outerTriangles.size());
+				outerTriangles.push_back(triangle);
+			}
+		};
+
+		DelaunayEdge* edge = vertex->edge;
+		do
+		{
+			addTriangle(edge->face);
+			edge = edge->next->next->twin;
+		} while (edge && edge != vertex->edge);
 
-		const glm::vec3& v1 = edge->v->v;
-		const glm::vec3& v2 = edge->next->v->v;
-		const glm::vec3& v3 = edge->next->next->v->v;
-		Geom2DTest::TriangleCircumcenter(v1, v2, v3, center, radius);
-		
-		// check if the opposite vertex to v3 lies in the circle to determine that the edge is illegal
-		if (Geom2DTest::PointInCircle(twin->next->next->v->v, center, radius))
+		if (edge)
 		{
-			return true;
+			return;
 		}
 
-		return false;
+		// the other way, up to the boundary too
+		edge = vertex->edge->twin;
+		while (edge)
+		{
+			edge = edge->next;
+			addTriangle(edge->face);
+			edge = edge->twin;
+		}
 	}
 
-	// Get final triangulation
-	void GetFinalTriangulation(std::vector<DelaunayTriangle*>& triangulation)
+	// Is the triangle a leaf of the live triangulation, the triangles of the root triangle included (the root triangle
+	// itself is left as the root of the history)
+	bool IsLiveTriangle(const DelaunayTriangle* triangle) const
 	{
-		// discard those leaf triangles that do not share any of the vertexes of the root triangle
-		const DelaunayVertex* v1 = rootTriangle->edge->v;
-		const DelaunayVertex* v2 = rootTriangle->edge->next->v;
-		const DelaunayVertex* v3 = rootTriangle->edge->next->next->v;
+		return triangle->edge && triangle->IsLeaf() && triangle != rootTriangle;
+	}
+
+	// Update the mesh of the triangulation after Insert or Remove from the touched triangles, appending the indices of the
+	// mesh triangles that changed
+	void UpdateTriangulationMesh(std::vector<uint32_t>& changedTriangles)
+	{
+		DELAUNAY_STATS_TIMER(stats.extractionTime);
+
+		std::sort(touchedTriangles.begin(), touchedTriangles.end());
+		touchedTriangles.erase(std::unique(touchedTriangles.begin(), touchedTriangles.end()), touchedTriangles.end());
 
-		for (size_t i = 0; i < numDelaunayTriangleUsed; i++)
+		// the triangles that left the triangulation (or the pool) free their slots
+		std::vector<uint32_t> freeSlots;
+		for (auto triangle : touchedTriangles)
 		{
-			DelaunayTriangle& triangle = trianglesPool[i];
-			if (triangle.children.size() == 0)
+			if (triangle->exportIndex >= 0 && !IsTriangulationTriangle(triangle))
 			{
-				if (	triangle.edge->v == v1 || triangle.edge->next->v == v1 || triangle.edge->next->next->v == v1 
-					||	triangle.edge->v == v2 || triangle.edge->next->v == v2 || triangle.edge->next->next->v == v2
-					||	triangle.edge->v == v3 || triangle.edge->next->v == v3 || triangle.edge->next->next->v == v3)
-				{
-					// discard triangle by breaking twin and parent-child relationship
-					BreakTwinRelationship(triangle.edge);
-					BreakTwinRelationship(triangle.edge->next);
-					BreakTwinRelationship(triangle.edge->next->next);
+				freeSlots.push_back(triangle->exportIndex);
+				meshTriangles[triangle->exportIndex] = nullptr;
+				triangle->exportIndex = -1;
+			}
+		}
+
+		// the ones that joined it take them, or go at the end
+		std::vector<DelaunayTriangle*> rewrittenTriangles;
+		for (auto triangle : touchedTriangles)
+		{
+			if (!IsTriangulationTriangle(triangle))
+			{
+				continue;
+			}
 
-					BreakParentChildRelationShip(&triangle);
+			if (triangle->exportIndex < 0)
+			{
+				if (!freeSlots.empty())
+				{
+					triangle->exportIndex = freeSlots.back();
+					freeSlots.pop_back();
 				}
 				else
 				{
-					// add triangle to triangulation
-					triangulation.push_back(&triangle);
+					triangle->exportIndex = triangulationMesh.AddTriangle(0, 0, 0);
+					meshTriangles.push_back(nullptr);
+				}
+
+				meshTriangles[triangle->exportIndex] = triangle;
+			}
+
+			rewrittenTriangles.push_back(triangle);
+		}
+
+		// the slots left over are filled with the last triangles, so the mesh stays compact
+		std::sort(freeSlots.begin(), freeSlots.end());
+		while (!freeSlots.empty())
+		{
+			uint32_t lastSlot = triangulationMesh.NumTriangles() - 1;
+			if (freeSlots.back() == lastSlot)
+			{
+				freeSlots.pop_back();
+			}
+			else
+			{
+				DelaunayTriangle* triangle = meshTriangles[lastSlot];
+				triangle->exportIndex = freeSlots.back();
+				meshTriangles[triangle->exportIndex] = triangle;
+				freeSlots.pop_back();
+
+				rewrittenTriangles.push_back(triangle);
+			}
+
+			meshTriangles.pop_back();
+			triangulationMesh.origins.resize(3 * lastSlot);
+			triangulationMesh.twins.resize(3 * lastSlot);
+			triangulationMesh.nexts.resize(3 * lastSlot);
+			triangulationMesh.faces.resize(3 * lastSlot);
+		}
+
+		for (auto triangle : rewrittenTriangles)
+		{
+			const DelaunayEdge* edge = triangle->edge;
+			for (uint32_t j = 0; j < 3; j++, edge = edge->next)
+			{
+				// the vertices added go at the end of the mesh
+				DelaunayVertex* vertex = edge->v;
+				if (vertex->exportIndex < 0)
+				{
+					vertex->exportIndex = (int)triangulationMesh.AddVertex(vertex->v);
+					meshVertices.push_back(vertex);
 				}
+
+				triangulationMesh.origins[3 * triangle->exportIndex + j] = vertex->exportIndex;
+			}
+
+			changedTriangles.push_back(triangle->exportIndex);
+		}
+
+		// the twins of the touched triangles and of their neighbours in the triangulation (which may face a triangle that
+		// left it), and the ones of the triangles moved to fill the slots
+		for (auto triangle : touchedTriangles)
+		{
+			UpdateTriangulationMeshTwins(triangle);
+		}
+
+		for (auto triangle : rewrittenTriangles)
+		{
+			if (!std::binary_search(touchedTriangles.begin(), touchedTriangles.end(), triangle))
+			{
+				UpdateTriangulationMeshTwins(triangle);
 			}
 		}
 	}
 
-	// Break twin relationship
-	void BreakTwinRelationship(DelaunayEdge* edge)
+	// Update the mesh twins of the edges of the triangle, from both sides
+	void UpdateTriangulationMeshTwins(const DelaunayTriangle* triangle)
 	{
-		if (edge->twin) 
-			edge->twin->twin = nullptr;
+		const DelaunayEdge* edge = triangle->edge;
+		for (uint32_t j = 0; edge && j < 3; j++, edge = edge->next)
+		{
+			// the edges of a split triangle keep pointing to twins that no longer point back
+			const DelaunayEdge* twin = edge->twin;
+			bool twinKept = twin && twin->twin == edge && twin->face->exportIndex >= 0;
+			uint32_t meshTwin = twinKept ? 3 * twin->face->exportIndex + EdgeSlot(twin) : DelaunayMesh::INVALID_INDEX;
+
+			if (triangle->exportIndex >= 0)
+			{
+				uint32_t meshEdge = 3 * triangle->exportIndex + j;
+				triangulationMesh.twins[meshEdge] = meshTwin;
+				if (twinKept)
+				{
+					triangulationMesh.twins[meshTwin] = meshEdge;
+				}
+			}
+			else if (twinKept)
+			{
+				triangulationMesh.twins[meshTwin] = DelaunayMesh::INVALID_INDEX;
+			}
+		}
 	}
 
-	// Break parent relationship
-	void BreakParentChildRelationShip(DelaunayTriangle* triangle)
+	// Edge slot (0, 1 or 2) of the edge inside its triangle
+	uint32_t EdgeSlot(const DelaunayEdge* edge)
 	{
-		auto& parentChildren = triangle->parent->children;
-		auto childTriangle = std::find(parentChildren.begin(), parentChildren.end(), triangle);
-		assert(childTriangle != parentChildren.end());
-		parentChildren.erase(childTriangle);
-
-		triangle->parent = nullptr;
+		const DelaunayEdge* first = edge->face->edge;
+		return (first == edge) ? 0 : (first->next == edge) ? 1 : 2;
 	}
 
 	// Print debug info
@@ -666,8 +3843,7 @@ private:
 
 	void PrintTriangleInfo(const DelaunayTriangle* triangle)
 	{
-		auto& children = triangle->children;
-		if (children.size() == 0)
+		if (triangle->IsLeaf())
 		{
 			PrintTriangleLeafInfo(triangle);
 		}
@@ -675,27 +3851,19 @@ private:
 		{
 			PrintTriangleNodeInfo(triangle);
 
-			for (size_t i = 0; i < children.size(); i++)
+			for (int i = 0; i < triangle->numChildren; i++)
 			{
-				PrintTriangleInfo(children[i]);
+				PrintTriangleInfo(triangle->children[i]);
 			}
 		}
 	}
 
 	void PrintTriangleLeafInfo(const DelaunayTriangle* triangle)
 	{
-		glm::vec3 v1 = triangle->v1;
-		glm::vec3 v2 = triangle->v2;
-		glm::vec3 v3 = triangle->v3;
-
-		printf("-- Leaf (%f, %f) (%f, %f) (%f, %f)\n", v1.x, v1.z, v2.x, v2.z, v3.x, v3.z);
+		PrintTriangleVertices("-- Leaf", triangle);
 		if (triangle->parent)
 		{
-			glm::vec3 pv1 = triangle->parent->v1;
-			glm::vec3 pv2 = triangle->parent->v2;
-			glm::vec3 pv3 = triangle->parent->v3;
-
-			printf("  Parent (%f, %f) (%f, %f) (%f, %f)\n", pv1.x, pv1.z, pv2.x, pv2.z, pv3.x, pv3.z);
+			PrintTriangleVertices("  Parent", triangle->parent);
 		}
 		else
 		{
@@ -708,18 +3876,10 @@ private:
 
 	void PrintTriangleNodeInfo(const DelaunayTriangle* triangle)
 	{
-		glm::vec3 v1 = triangle->v1;
-		glm::vec3 v2 = triangle->v2;
-		glm::vec3 v3 = triangle->v3;
-
-		printf("-- Node (%f, %f) (%f, %f) (%f, %f)\n", v1.x, v1.z, v2.x, v2.z, v3.x, v3.z);
+		PrintTriangleVertices("-- Node", triangle);
 		if (triangle->parent)
 		{
-			glm::vec3 pv1 = triangle->parent->v1;
-			glm::vec3 pv2 = triangle->parent->v2;
-			glm::vec3 pv3 = triangle->parent->v3;
-
-			printf("  Parent (%f, %f) (%f, %f) (%f, %f)\n", pv1.x, pv1.z, pv2.x, pv2.z, pv3.x, pv3.z);
+			PrintTriangleVertices("  Parent", triangle->parent);
 		}
 		else
 		{
@@ -730,6 +3890,22 @@ private:
 		PrintTriangleEdgesInfo(triangle);
 	}
 
+	// Print the vertices of the triangle, taken from its half-edges (a root triangle restored from a snapshot has none)
+	void PrintTriangleVertices(const char* label, const DelaunayTriangle* triangle)
+	{
+		if (!triangle->edge)
+		{
+			printf("%s without edges\n", label);
+			return;
+		}
+
+		glm::vec3 v1 = triangle->edge->v->v;
+		glm::vec3 v2 = triangle->edge->next->v->v;
+		glm::vec3 v3 = triangle->edge->next->next->v->v;
+
+		printf("%s (%f, %f) (%f, %f) (%f, %f)\n", label, v1.x, v1.z, v2.x, v2.z, v3.x, v3.z);
+	}
+
 	void PrintTriangleEdgesInfo(const DelaunayTriangle* triangle)
 	{
 		glm::vec3 v1 = triangle->edge->v->v;
@@ -775,6 +3951,12 @@ private:
 
 };
 
-const float Delaunay::s_rootTriangleExpansion = 1000.0f;
+const float Delaunay::s_rootTriangleExpansion = 10.0f;
+const size_t Delaunay::s_parallelFirstBatchSize = 256;
+const size_t Delaunay::s_parallelMinBlockSize = 64;
+const float Delaunay::s_refinementMaxAngle = 33.8f;
+const float Delaunay::s_refinementMinEdgeLength = 1e-5f;
+const double Delaunay::s_streamCircleTolerance = 1e-6;
+const int Delaunay::s_latticeBits = 29;
 
 #endif
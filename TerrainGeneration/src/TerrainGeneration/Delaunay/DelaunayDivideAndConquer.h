@@ -0,0 +1,470 @@
+#ifndef DELAUNAY_DIVIDE_AND_CONQUER_H
+#define DELAUNAY_DIVIDE_AND_CONQUER_H
+
+#include "../../Geom2DTest/Geom2DTest.h"
+#include "../../Parallel/Parallel.h"
+#include "DelaunayEngine.h"
+#include "DelaunayInsertionOrder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+// Divide and conquer Delaunay triangulation (Guibas & Stolfi, with Dwyer's alternating cuts).
+//
+// The points are split in halves recursively, alternating vertical and horizontal cuts so the sub-problems stay
+// roughly square; the halves are triangulated independently (in parallel at the top levels of the recursion) and
+// merged bottom to top. A horizontal cut is a vertical one in the frame rotated by 90 degrees, and rotations do not
+// change the predicates, so both cuts share the same merge.
+//
+// The topology is kept in a quad-edge like structure of directed edges: edge e and edge e ^ 1 are the two directions
+// of the same edge, and every directed edge knows the next edges counter-clockwise and clockwise around its origin
+class DelaunayDivideAndConquer : public DelaunayEngine
+{
+	static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+	// sub-problems smaller than this are not worth a thread
+	static const uint32_t MIN_PARALLEL_POINTS = 1 << 14;
+
+	// smallest block of the linear passes run in parallel
+	static const size_t MIN_BLOCK_SIZE = 1 << 14;
+
+	// Edges of a sub-problem. Every sub-problem gets its own range of edge pairs (3 per point, which is more than a planar
+	// graph can use), so concurrent sub-problems never share edges; merging two sub-problems concatenates their edges
+	struct EdgeAllocator
+	{
+		uint32_t nextPair = 0;
+		uint32_t endPair = 0;
+		std::vector<uint32_t> freePairs;
+
+		EdgeAllocator(uint32_t firstPair, uint32_t endPair) : nextPair(firstPair), endPair(endPair) {}
+	};
+
+	// points without duplicates (reordered by the cuts)
+	std::vector<glm::vec3> points;
+
+	// directed edges
+	std::vector<uint32_t> origins;	// origin point (INVALID_INDEX when deleted)
+	std::vector<uint32_t> onexts;	// next edge counter-clockwise around the origin
+	std::vector<uint32_t> oprevs;	// next edge clockwise around the origin
+
+	// half-edge of the mesh on every directed edge (extraction of the triangles)
+	std::vector<uint32_t> meshEdges;
+
+public:
+
+	DelaunayDivideAndConquer() {}
+	~DelaunayDivideAndConquer() {}
+
+	// Triangulate the points into the mesh
+	void Triangulate(const std::vector<glm::vec3>& pointCloud, DelaunayMesh& mesh) override
+	{
+		mesh.Clear();
+
+		SortPoints(pointCloud);
+
+		uint32_t numPoints = (uint32_t)points.size();
+		if (numPoints < 2)
+		{
+			CopyVertices(mesh);
+			return;
+		}
+
+		uint32_t numEdges = 6 * numPoints;
+		origins.assign(numEdges, INVALID_INDEX);
+		onexts.resize(numEdges);
+		oprevs.resize(numEdges);
+
+		// one level of parallel recursion per doubling of the threads
+		int depth = 0;
+		while (((size_t)1 << depth) < Parallel::NumThreads())
+		{
+			depth++;
+		}
+
+		EdgeAllocator allocator(0, 3 * numPoints);
+		TriangulateRange(0, numPoints, 0, depth, allocator);
+
+		// the cuts have reordered the points
+		CopyVertices(mesh);
+		ExtractTriangles(mesh);
+	}
+
+	// Release the memory used by the triangulation
+	void ReleaseMemory() override
+	{
+		points = std::vector<glm::vec3>();
+		origins = std::vector<uint32_t>();
+		onexts = std::vector<uint32_t>();
+		oprevs = std::vector<uint32_t>();
+		meshEdges = std::vector<uint32_t>();
+	}
+
+private:
+
+	// Remove the duplicated points (sorting them lexicographically first, which also sets up the first vertical cut). The
+	// duplicates end up next to each other, so the first point of every run is kept with a parallel compaction
+	void SortPoints(const std::vector<glm::vec3>& pointCloud)
+	{
+		std::vector<uint32_t> order;
+		SpatialSort::LexicographicOrder(pointCloud, order);
+
+		points.resize(pointCloud.size());
+
+		size_t numPoints = Parallel::Compact(order.size(), MIN_BLOCK_SIZE, [&pointCloud, &order](size_t i)
+		{
+			const glm::vec3& point = pointCloud[order[i]];
+			return i == 0 || pointCloud[order[i - 1]].x != point.x || pointCloud[order[i - 1]].z != point.z;
+		},
+		[this, &pointCloud, &order](size_t i, size_t index)
+		{
+			points[index] = pointCloud[order[i]];
+		});
+
+		points.resize(numPoints);
+	}
+
+	// Copy the points to the vertices of the mesh
+	void CopyVertices(DelaunayMesh& mesh) const
+	{
+		mesh.positions.resize(points.size());
+		mesh.heights.resize(points.size());
+
+		Parallel::For(0, points.size(), MIN_BLOCK_SIZE, [this, &mesh](size_t i)
+		{
+			mesh.positions[i] = glm::vec2(points[i].x, points[i].z);
+			mesh.heights[i] = points[i].y;
+		});
+	}
+
+	// Is point a before point b along the axis (0: x then z, 1: z then -x, which is axis 0 rotated by 90 degrees)
+	static bool Before(const glm::vec3& a, const glm::vec3& b, int axis)
+	{
+		if (axis == 0)
+		{
+			return a.x < b.x || (a.x == b.x && a.z < b.z);
+		}
+
+		return a.z < b.z || (a.z == b.z && a.x > b.x);
+	}
+
+	// Triangulate the points [begin, end), cutting them along the axis. Returns a convex hull edge with the outer face on
+	// its left
+	uint32_t TriangulateRange(uint32_t begin, uint32_t end, int axis, int depth, EdgeAllocator& allocator)
+	{
+		uint32_t numPoints = end - begin;
+
+		if (numPoints == 2)
+		{
+			return MakeEdge(allocator, begin, begin + 1);
+		}
+
+		if (numPoints == 3)
+		{
+			std::sort(points.begin() + begin, points.begin() + end, [axis](const glm::vec3& a, const glm::vec3& b) { return Before(a, b, axis); });
+
+			uint32_t a = MakeEdge(allocator, begin, begin + 1);
+			uint32_t b = MakeEdge(allocator, begin + 1, begin + 2);
+			Splice(Sym(a), b);
+
+			double orientation = Geom2DTest::Orient2D(points[begin], points[begin + 1], points[begin + 2]);
+			if (orientation > 0.0)
+			{
+				Connect(allocator, b, a);
+			}
+			else if (orientation < 0.0)
+			{
+				return Connect(allocator, b, a);
+			}
+
+			return Sym(b);
+		}
+
+		// cut the points in two halves along the axis
+		uint32_t middle = begin + numPoints / 2;
+		std::nth_element(points.begin() + begin, points.begin() + middle, points.begin() + end,
+			[axis](const glm::vec3& a, const glm::vec3& b) { return Before(a, b, axis); });
+
+		// triangulate both halves, cutting them along the other axis
+		uint32_t leftHull, rightHull;
+		if (depth > 0 && numPoints >= MIN_PARALLEL_POINTS)
+		{
+			EdgeAllocator leftAllocator(3 * begin, 3 * middle);
+			EdgeAllocator rightAllocator(3 * middle, 3 * end);
+
+			Parallel::Invoke(
+				[&]() { leftHull = TriangulateRange(begin, middle, 1 - axis, depth - 1, leftAllocator); },
+				[&]() { rightHull = TriangulateRange(middle, end, 1 - axis, depth - 1, rightAllocator); });
+
+			// the merge takes whatever edges are left in both halves
+			allocator.freePairs = std::move(leftAllocator.freePairs);
+			for (uint32_t pair = leftAllocator.nextPair; pair < leftAllocator.endPair; pair++)
+			{
+				allocator.freePairs.push_back(pair);
+			}
+			allocator.freePairs.insert(allocator.freePairs.end(), rightAllocator.freePairs.begin(), rightAllocator.freePairs.end());
+			allocator.nextPair = rightAllocator.nextPair;
+			allocator.endPair = rightAllocator.endPair;
+		}
+		else
+		{
+			leftHull = TriangulateRange(begin, middle, 1 - axis, 0, allocator);
+			rightHull = TriangulateRange(middle, end, 1 - axis, 0, allocator);
+		}
+
+		// hull edges at the extremes of the halves along this axis
+		uint32_t ldo, ldi, rdi, rdo;
+		FindExtremeHullEdges(leftHull, axis, ldo, ldi);
+		FindExtremeHullEdges(rightHull, axis, rdi, rdo);
+
+		return Merge(allocator, ldi, rdi);
+	}
+
+	// Walk the convex hull (given by an edge with the outer face on its left) and get the counter-clockwise hull edge out
+	// of the first point along the axis and the clockwise hull edge out of the last one
+	void FindExtremeHullEdges(uint32_t hullEdge, int axis, uint32_t& firstEdge, uint32_t& lastEdge) const
+	{
+		// the destination of every hull edge, in clockwise order
+		uint32_t first = hullEdge;
+		uint32_t last = hullEdge;
+		uint32_t edge = hullEdge;
+		do
+		{
+			if (Before(points[Dest(edge)], points[Dest(first)], axis))
+			{
+				first = edge;
+			}
+			if (Before(points[Dest(last)], points[Dest(edge)], axis))
+			{
+				last = edge;
+			}
+			edge = Lnext(edge);
+		} while (edge != hullEdge);
+
+		firstEdge = Sym(first);
+		lastEdge = Lnext(last);
+	}
+
+	// Merge the triangulations of two halves, stitching them from the lower common tangent upwards. ldi is the clockwise
+	// hull edge out of the last point of the left half and rdi the counter-clockwise hull edge out of the first point of
+	// the right half. Returns the lower common tangent, a hull edge of the merged triangulation with the outer face on its left
+	uint32_t Merge(EdgeAllocator& allocator, uint32_t ldi, uint32_t rdi)
+	{
+		// lower common tangent
+		for (;;)
+		{
+			if (LeftOf(Org(rdi), ldi))
+			{
+				ldi = Lnext(ldi);
+			}
+			else if (RightOf(Org(ldi), rdi))
+			{
+				rdi = Rprev(rdi);
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		uint32_t basel = Connect(allocator, Sym(rdi), ldi);
+		uint32_t tangent = basel;
+		for (;;)
+		{
+			// left candidate, deleting the left edges that fail the in circle test
+			uint32_t lcand = Onext(Sym(basel));
+			if (Valid(lcand, basel))
+			{
+				while (InCircle(Dest(basel), Org(basel), Dest(lcand), Dest(Onext(lcand))))
+				{
+					uint32_t next = Onext(lcand);
+					DeleteEdge(allocator, lcand);
+					lcand = next;
+				}
+			}
+
+			// right candidate, deleting the right edges that fail the in circle test
+			uint32_t rcand = Oprev(basel);
+			if (Valid(rcand, basel))
+			{
+				while (InCircle(Dest(basel), Org(basel), Dest(rcand), Dest(Oprev(rcand))))
+				{
+					uint32_t next = Oprev(rcand);
+					DeleteEdge(allocator, rcand);
+					rcand = next;
+				}
+			}
+
+			bool validLeft = Valid(lcand, basel);
+			bool validRight = Valid(rcand, basel);
+			if (!validLeft && !validRight)
+			{
+				// basel is the upper common tangent
+				break;
+			}
+
+			// connect to the candidate whose circle is empty
+			if (!validLeft || (validRight && InCircle(Dest(lcand), Org(lcand), Org(rcand), Dest(rcand))))
+			{
+				basel = Connect(allocator, rcand, Sym(basel));
+			}
+			else
+			{
+				basel = Connect(allocator, Sym(basel), Sym(lcand));
+			}
+		}
+
+		return tangent;
+	}
+
+	// Extract the triangles (clockwise in the xz plane, as the mesh expects) and their twins. Every face is a cycle of
+	// directed edges and belongs to its smallest edge, so the triangles are numbered with a parallel compaction over the
+	// edges and then every directed edge sets the twin of its half-edge
+	void ExtractTriangles(DelaunayMesh& mesh)
+	{
+		uint32_t numEdges = (uint32_t)origins.size();
+		meshEdges.resize(numEdges);
+
+		// every triangle takes 3 edges, which bounds their number
+		mesh.origins.resize(numEdges - numEdges % 3);
+
+		size_t numTriangles = Parallel::Compact(numEdges, MIN_BLOCK_SIZE, [this](size_t i)
+		{
+			uint32_t e0 = (uint32_t)i;
+			meshEdges[e0] = INVALID_INDEX;
+
+			if (origins[e0] == INVALID_INDEX)
+			{
+				return false;
+			}
+
+			// faces are traversed counter-clockwise, except the outer one
+			uint32_t e1 = Lnext(e0);
+			uint32_t e2 = Lnext(e1);
+			return	Lnext(e2) == e0 && e0 < e1 && e0 < e2
+				&&	Geom2DTest::Orient2D(points[Org(e0)], points[Org(e1)], points[Org(e2)]) > 0.0;
+		},
+		[this, &mesh](size_t i, size_t triangle)
+		{
+			uint32_t e0 = (uint32_t)i;
+			uint32_t e1 = Lnext(e0);
+			uint32_t e2 = Lnext(e1);
+
+			// (a, b, c) counter-clockwise is (a, c, b) clockwise, whose half-edges lie on e2, e1 and e0
+			uint32_t edge = 3 * (uint32_t)triangle;
+			mesh.origins[edge] = Org(e0);
+			mesh.origins[edge + 1] = Org(e2);
+			mesh.origins[edge + 2] = Org(e1);
+
+			meshEdges[e2] = edge;
+			meshEdges[e1] = edge + 1;
+			meshEdges[e0] = edge + 2;
+		});
+
+		mesh.origins.resize(3 * numTriangles);
+		mesh.twins.resize(3 * numTriangles);
+
+		Parallel::For(0, numEdges, MIN_BLOCK_SIZE, [this, &mesh](size_t e)
+		{
+			if (meshEdges[e] != INVALID_INDEX)
+			{
+				mesh.twins[meshEdges[e]] = meshEdges[Sym((uint32_t)e)];
+			}
+		});
+
+		mesh.LinkTriangles();
+	}
+
+	// Edge algebra
+	uint32_t Sym(uint32_t e) const { return e ^ 1; }
+	uint32_t Org(uint32_t e) const { return origins[e]; }
+	uint32_t Dest(uint32_t e) const { return origins[e ^ 1]; }
+	uint32_t Onext(uint32_t e) const { return onexts[e]; }
+	uint32_t Oprev(uint32_t e) const { return oprevs[e]; }
+	uint32_t Lnext(uint32_t e) const { return oprevs[e ^ 1]; }
+	uint32_t Rprev(uint32_t e) const { return onexts[e ^ 1]; }
+
+	// Make an isolated edge from a to b
+	uint32_t MakeEdge(EdgeAllocator& allocator, uint32_t a, uint32_t b)
+	{
+		uint32_t pair;
+		if (!allocator.freePairs.empty())
+		{
+			pair = allocator.freePairs.back();
+			allocator.freePairs.pop_back();
+		}
+		else
+		{
+			assert(allocator.nextPair < allocator.endPair);
+			pair = allocator.nextPair++;
+		}
+
+		uint32_t e = 2 * pair;
+		origins[e] = a;
+		origins[e + 1] = b;
+		onexts[e] = oprevs[e] = e;
+		onexts[e + 1] = oprevs[e + 1] = e + 1;
+
+		return e;
+	}
+
+	// Splice the rings of edges around the origins of a and b (joins them when different, splits them when the same)
+	void Splice(uint32_t a, uint32_t b)
+	{
+		uint32_t alpha = onexts[a];
+		uint32_t beta = onexts[b];
+
+		onexts[a] = beta;
+		onexts[b] = alpha;
+		oprevs[beta] = a;
+		oprevs[alpha] = b;
+	}
+
+	// Add an edge from the destination of a to the origin of b, leaving a, the new edge and b in the same left face
+	uint32_t Connect(EdgeAllocator& allocator, uint32_t a, uint32_t b)
+	{
+		uint32_t e = MakeEdge(allocator, Dest(a), Org(b));
+		Splice(e, Lnext(a));
+		Splice(Sym(e), b);
+
+		return e;
+	}
+
+	// Delete edge
+	void DeleteEdge(EdgeAllocator& allocator, uint32_t e)
+	{
+		Splice(e, Oprev(e));
+		Splice(Sym(e), Oprev(Sym(e)));
+
+		origins[e] = origins[Sym(e)] = INVALID_INDEX;
+		allocator.freePairs.push_back(e / 2);
+	}
+
+	// Predicates
+	bool LeftOf(uint32_t point, uint32_t e) const
+	{
+		return Geom2DTest::Orient2D(points[point], points[Org(e)], points[Dest(e)]) > 0.0;
+	}
+
+	bool RightOf(uint32_t point, uint32_t e) const
+	{
+		return Geom2DTest::Orient2D(points[point], points[Dest(e)], points[Org(e)]) > 0.0;
+	}
+
+	bool Valid(uint32_t e, uint32_t basel) const
+	{
+		return RightOf(Dest(e), basel);
+	}
+
+	bool InCircle(uint32_t a, uint32_t b, uint32_t c, uint32_t d) const
+	{
+		return Geom2DTest::InCircle(points[a], points[b], points[c], points[d]) > 0.0;
+	}
+};
+
+const uint32_t DelaunayDivideAndConquer::INVALID_INDEX;
+const uint32_t DelaunayDivideAndConquer::MIN_PARALLEL_POINTS;
+const size_t DelaunayDivideAndConquer::MIN_BLOCK_SIZE;
+
+#endif // !DELAUNAY_DIVIDE_AND_CONQUER_H
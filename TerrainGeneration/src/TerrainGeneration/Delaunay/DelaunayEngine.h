@@ -0,0 +1,27 @@
+#ifndef DELAUNAY_ENGINE_H
+#define DELAUNAY_ENGINE_H
+
+#include "DelaunayMesh.h"
+
+#include <vector>
+
+// Triangulation engine that triangulates a set of points in one shot, writing the result into a compact half-edge mesh.
+//
+// The incremental algorithm of Delaunay is not an engine of this kind: it is the one that keeps the pointer based
+// triangulation around, so it can be built step by step
+class DelaunayEngine
+{
+public:
+	virtual ~DelaunayEngine() {}
+
+	// Triangulate the points into the mesh
+	virtual void Triangulate(const std::vector<glm::vec3>& points, DelaunayMesh& mesh) = 0;
+
+	// Release the memory used by the triangulation
+	virtual void ReleaseMemory() = 0;
+
+protected:
+	DelaunayEngine() {}
+};
+
+#endif // !DELAUNAY_ENGINE_H
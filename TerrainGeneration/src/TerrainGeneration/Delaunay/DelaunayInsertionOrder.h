@@ -0,0 +1,144 @@
+#ifndef DELAUNAY_INSERTION_ORDER_H
+#define DELAUNAY_INSERTION_ORDER_H
+
+#include "glm/glm.hpp"
+#include "../../Parallel/Parallel.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+enum class DelaunayInsertionOrder
+{
+	AS_GIVEN,		// insert the points in the order they are stored in the point cloud
+	BRIO_HILBERT	// biased randomized insertion order with Hilbert sorting inside each round
+};
+
+namespace SpatialSort
+{
+	// Hilbert curve index of a cell in a 2^16 x 2^16 grid
+	uint32_t HilbertIndex(uint32_t x, uint32_t z)
+	{
+		const uint32_t N = 1 << 16;
+
+		uint32_t d = 0;
+		for (uint32_t s = N / 2; s > 0; s /= 2)
+		{
+			uint32_t rx = (x & s) > 0;
+			uint32_t rz = (z & s) > 0;
+			d += s * s * ((3 * rx) ^ rz);
+
+			// rotate the quadrant
+			if (rz == 0)
+			{
+				if (rx == 1)
+				{
+					x = N - 1 - x;
+					z = N - 1 - z;
+				}
+				std::swap(x, z);
+			}
+		}
+
+		return d;
+	}
+
+	// Key whose unsigned integer order matches the order of the float value
+	uint32_t FloatKey(float value)
+	{
+		// -0 and 0 get the same key
+		value = (value == 0.0f) ? 0.0f : value;
+
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+	}
+
+	// Lexicographic (x, then z) order of the points
+	void LexicographicOrder(const std::vector<glm::vec3>& points, std::vector<uint32_t>& order)
+	{
+		size_t numPoints = points.size();
+		order.resize(numPoints);
+
+		// the radix sort is stable, so sorting by z and then by x leaves the points with the same x sorted by z
+		std::vector<uint64_t> items(numPoints);
+		Parallel::For(0, numPoints, 1 << 14, [&](size_t i)
+		{
+			items[i] = ((uint64_t)FloatKey(points[i].z) << 32) | i;
+		});
+		Parallel::RadixSortByKey(items.data(), numPoints);
+
+		Parallel::For(0, numPoints, 1 << 14, [&](size_t i)
+		{
+			uint32_t index = (uint32_t)items[i];
+			items[i] = ((uint64_t)FloatKey(points[index].x) << 32) | index;
+		});
+		Parallel::RadixSortByKey(items.data(), numPoints);
+
+		Parallel::For(0, numPoints, 1 << 14, [&](size_t i)
+		{
+			order[i] = (uint32_t)items[i];
+		});
+	}
+
+	// Biased randomized insertion order (BRIO): the points are shuffled and split in rounds of doubling size,
+	// and the points of every round are sorted along a Hilbert curve so consecutive insertions are spatially close
+	void BiasedRandomizedInsertionOrder(const std::vector<glm::vec3>& points, std::vector<uint32_t>& order)
+	{
+		const size_t MIN_ROUND_SIZE = 64;
+
+		size_t numPoints = points.size();
+		order.resize(numPoints);
+		if (numPoints == 0)
+		{
+			return;
+		}
+
+		// bounding rectangle used to quantize the points to the Hilbert grid
+		glm::vec3 min = points[0];
+		glm::vec3 max = points[0];
+		for (auto& point : points)
+		{
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+
+		float scaleX = (max.x > min.x) ? 65535.0f / (max.x - min.x) : 0.0f;
+		float scaleZ = (max.z > min.z) ? 65535.0f / (max.z - min.z) : 0.0f;
+
+		// random assignment of the points to rounds (fixed seed so triangulations are reproducible)
+		std::iota(order.begin(), order.end(), 0);
+		std::shuffle(order.begin(), order.end(), std::mt19937(0x5EED));
+
+		// key in the upper 32 bits, point index in the lower 32 bits
+		std::vector<uint64_t> items(numPoints);
+		Parallel::For(0, numPoints, 1 << 14, [&](size_t i)
+		{
+			const glm::vec3& point = points[order[i]];
+			uint32_t x = std::min(65535u, (uint32_t)((point.x - min.x) * scaleX));
+			uint32_t z = std::min(65535u, (uint32_t)((point.z - min.z) * scaleZ));
+
+			items[i] = ((uint64_t)HilbertIndex(x, z) << 32) | order[i];
+		});
+
+		// rounds are [n/2, n), [n/4, n/2), ... and whatever is left below MIN_ROUND_SIZE
+		size_t end = numPoints;
+		while (end > 0)
+		{
+			size_t begin = (end > 2 * MIN_ROUND_SIZE) ? end / 2 : 0;
+			Parallel::RadixSortByKey(&items[begin], end - begin);
+			end = begin;
+		}
+
+		Parallel::For(0, numPoints, 1 << 14, [&](size_t i)
+		{
+			order[i] = (uint32_t)items[i];
+		});
+	}
+}
+
+#endif // !DELAUNAY_INSERTION_ORDER_H
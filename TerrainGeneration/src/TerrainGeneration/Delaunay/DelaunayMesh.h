@@ -0,0 +1,105 @@
+#ifndef DELAUNAY_MESH_H
+#define DELAUNAY_MESH_H
+
+#include "glm/glm.hpp"
+#include "../../Parallel/Parallel.h"
+
+#include <cstdint>
+#include <vector>
+
+// Compact index based half-edge mesh stored as structure of arrays.
+//
+// Triangle t owns the half-edges 3t, 3t + 1 and 3t + 2 (in that order), so the origins array doubles as
+// the index buffer of the triangles. Boundary half-edges have no twin
+struct DelaunayMesh
+{
+	static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+	// vertices: planar coordinates (x, z) and heights (y)
+	std::vector<glm::vec2> positions;
+	std::vector<float> heights;
+
+	// half-edges
+	std::vector<uint32_t> origins;	// vertex where the half-edge starts
+	std::vector<uint32_t> twins;	// matching half-edge of the opposing triangle
+	std::vector<uint32_t> nexts;	// next half-edge of the triangle
+	std::vector<uint32_t> faces;	// triangle the half-edge belongs to
+
+	// Clear
+	void Clear()
+	{
+		positions.clear();
+		heights.clear();
+
+		origins.clear();
+		twins.clear();
+		nexts.clear();
+		faces.clear();
+	}
+
+	// Add vertex
+	uint32_t AddVertex(const glm::vec3& v)
+	{
+		positions.push_back(glm::vec2(v.x, v.z));
+		heights.push_back(v.y);
+
+		return (uint32_t)positions.size() - 1;
+	}
+
+	// Add triangle (the twins are left unset)
+	uint32_t AddTriangle(uint32_t v1, uint32_t v2, uint32_t v3)
+	{
+		uint32_t triangle = NumTriangles();
+		uint32_t edge = 3 * triangle;
+
+		origins.push_back(v1);
+		origins.push_back(v2);
+		origins.push_back(v3);
+
+		twins.insert(twins.end(), 3, INVALID_INDEX);
+
+		nexts.push_back(edge + 1);
+		nexts.push_back(edge + 2);
+		nexts.push_back(edge);
+
+		faces.insert(faces.end(), 3, triangle);
+
+		return triangle;
+	}
+
+	// Set the nexts and faces of the half-edges (for meshes whose origins and twins were filled directly)
+	void LinkTriangles()
+	{
+		uint32_t numHalfEdges = NumHalfEdges();
+		nexts.resize(numHalfEdges);
+		faces.resize(numHalfEdges);
+
+		Parallel::For(0, numHalfEdges, 1 << 16, [this](size_t i)
+		{
+			uint32_t edge = (uint32_t)i;
+			nexts[edge] = (edge % 3 == 2) ? edge - 2 : edge + 1;
+			faces[edge] = edge / 3;
+		});
+	}
+
+	// getters
+	uint32_t NumVertices() const { return (uint32_t)positions.size(); }
+	uint32_t NumHalfEdges() const { return (uint32_t)origins.size(); }
+	uint32_t NumTriangles() const { return (uint32_t)origins.size() / 3; }
+
+	// Vertex position in 3D
+	glm::vec3 Position(uint32_t vertex) const
+	{
+		return glm::vec3(positions[vertex].x, heights[vertex], positions[vertex].y);
+	}
+
+	// Triangle vertex (0, 1 or 2)
+	uint32_t TriangleVertex(uint32_t triangle, uint32_t i) const
+	{
+		return origins[3 * triangle + i];
+	}
+};
+
+const uint32_t DelaunayMesh::INVALID_INDEX;
+
+#endif // !DELAUNAY_MESH_H
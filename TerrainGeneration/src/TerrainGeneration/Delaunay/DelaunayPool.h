@@ -0,0 +1,116 @@
+#ifndef DELAUNAY_POOL_H
+#define DELAUNAY_POOL_H
+
+#include <memory>
+#include <vector>
+
+// Growable pool of objects allocated in fixed size chunks.
+// Chunks are never moved or reallocated, so pointers to pool objects stay valid until the pool memory is released.
+// Objects given back with Free are handed out again before the pool grows
+template<typename T>
+class DelaunayPool
+{
+	// objects per chunk
+	static const size_t CHUNK_SHIFT = 12;
+	static const size_t CHUNK_SIZE = size_t(1) << CHUNK_SHIFT;
+	static const size_t CHUNK_MASK = CHUNK_SIZE - 1;
+
+	// chunks of objects
+	std::vector< std::unique_ptr<T[]> > chunks;
+
+	// for tracking pool usage
+	size_t numUsed = 0;
+
+	// objects given back (cleared, so they can still be told apart when the used ones are visited)
+	std::vector<T*> freeObjects;
+
+public:
+	DelaunayPool() {};
+	~DelaunayPool() {};
+
+	// Get a new (cleared) object from the pool, growing the pool if needed
+	T* GetNew()
+	{
+		if (!freeObjects.empty())
+		{
+			T* object = freeObjects.back();
+			freeObjects.pop_back();
+
+			return object;
+		}
+
+		if (numUsed == Capacity())
+		{
+			AddChunk();
+		}
+
+		// objects are cleared when handed out, so forgetting the used ones is O(1)
+		T* object = &(*this)[numUsed++];
+		object->Clear();
+
+		return object;
+	}
+
+	// Give an object back to the pool
+	void Free(T* object)
+	{
+		object->Clear();
+		freeObjects.push_back(object);
+	}
+
+	// Hand out count objects at once, returning the index of the first one (the free objects are not used). They are not
+	// cleared, so whoever uses them has to (the objects can be reached through operator[] from several threads as long as the pool does not grow)
+	size_t GetNewRange(size_t count)
+	{
+		Reserve(numUsed + count);
+
+		size_t first = numUsed;
+		numUsed += count;
+
+		return first;
+	}
+
+	// Make room for at least numObjects objects
+	void Reserve(size_t numObjects)
+	{
+		while (Capacity() < numObjects)
+		{
+			AddChunk();
+		}
+	}
+
+	// Forget the objects in use (their memory is kept for reuse and they are cleared when handed out again)
+	void Reset()
+	{
+		numUsed = 0;
+		freeObjects.clear();
+	}
+
+	// Release the memory of the pool
+	void Release()
+	{
+		chunks.clear();
+		chunks.shrink_to_fit();
+		numUsed = 0;
+
+		freeObjects.clear();
+		freeObjects.shrink_to_fit();
+	}
+
+	// getters
+	size_t NumUsed() const { return numUsed; }
+	size_t Capacity() const { return chunks.size() * CHUNK_SIZE; }
+
+	T& operator[](size_t index) { return chunks[index >> CHUNK_SHIFT][index & CHUNK_MASK]; }
+	const T& operator[](size_t index) const { return chunks[index >> CHUNK_SHIFT][index & CHUNK_MASK]; }
+
+private:
+
+	// Add a new chunk
+	void AddChunk()
+	{
+		chunks.emplace_back(new T[CHUNK_SIZE]);
+	}
+};
+
+#endif // !DELAUNAY_POOL_H
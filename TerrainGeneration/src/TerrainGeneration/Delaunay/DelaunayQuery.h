@@ -0,0 +1,370 @@
+#ifndef DELAUNAY_QUERY_H
+#define DELAUNAY_QUERY_H
+
+#include "glm/glm.hpp"
+#include "../../Geom2DTest/Geom2DBatch.h"
+#include "../../Geom2DTest/Geom2DTest.h"
+#include "../../Parallel/Parallel.h"
+#include "DelaunayMesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+enum class DelaunayInterpolation
+{
+	LINEAR,				// barycentric interpolation of the heights of the triangle
+	NATURAL_NEIGHBOR	// Sibson interpolation of the heights of the natural neighbors (smooth across the edges)
+};
+
+// Result of a query at a position (x, z): the triangle that contains it (DelaunayMesh::INVALID_INDEX when the position is
+// outside the triangulation), the barycentric coordinates of the position for the vertices of the triangle and the height
+struct DelaunayQueryResult
+{
+	uint32_t triangle = DelaunayMesh::INVALID_INDEX;
+	glm::vec3 barycentric;
+	float height = 0.0f;
+};
+
+// Queries on a finished triangulation (its mesh). They only read the mesh, so any number of threads can query the same one
+// as long as nothing changes it in the meantime
+namespace DelaunayQuery
+{
+	// Position of the mesh vertex for the geometric tests (which work in the xz plane)
+	glm::vec3 TestPosition(const DelaunayMesh& mesh, uint32_t vertex)
+	{
+		return glm::vec3(mesh.positions[vertex].x, 0.0f, mesh.positions[vertex].y);
+	}
+
+	// Find the triangle that contains the point testing every triangle, in batches. Returns DelaunayMesh::INVALID_INDEX when
+	// no triangle contains it
+	uint32_t FindTriangle(const DelaunayMesh& mesh, const glm::vec3& point)
+	{
+		const uint32_t batchSize = 256;
+
+		// x and z of the point (the same in every case) and of the vertices of the triangles of the batch
+		std::vector<float> coordinates(8 * batchSize);
+		std::fill(coordinates.begin(), coordinates.begin() + batchSize, point.x);
+		std::fill(coordinates.begin() + batchSize, coordinates.begin() + 2 * batchSize, point.z);
+
+		Geom2DBatch::Points points[4];
+		for (int i = 0; i < 4; i++)
+		{
+			points[i] = { &coordinates[2 * i * batchSize], &coordinates[(2 * i + 1) * batchSize] };
+		}
+
+		std::vector<uint8_t> inside(batchSize);
+		for (uint32_t batchBegin = 0; batchBegin < mesh.NumTriangles(); batchBegin += batchSize)
+		{
+			uint32_t batchEnd = std::min(mesh.NumTriangles(), batchBegin + batchSize);
+			for (uint32_t triangle = batchBegin; triangle < batchEnd; triangle++)
+			{
+				for (uint32_t vertex = 0; vertex < 3; vertex++)
+				{
+					const glm::vec2& position = mesh.positions[mesh.TriangleVertex(triangle, vertex)];
+					coordinates[(2 * vertex + 2) * batchSize + triangle - batchBegin] = position.x;
+					coordinates[(2 * vertex + 3) * batchSize + triangle - batchBegin] = position.y;
+				}
+			}
+
+			Geom2DBatch::PointInTriangle(points[0], points[1], points[2], points[3], batchEnd - batchBegin, &inside[0]);
+
+			for (uint32_t triangle = batchBegin; triangle < batchEnd; triangle++)
+			{
+				if (inside[triangle - batchBegin])
+				{
+					return triangle;
+				}
+			}
+		}
+
+		return DelaunayMesh::INVALID_INDEX;
+	}
+
+	// Walk from the triangle given to the one that contains the point. Triangles are stored clockwise in the xz plane, so
+	// the point is beyond an edge when it lies counter-clockwise of it. Returns DelaunayMesh::INVALID_INDEX when the walk
+	// leaves the triangulation (the point is outside its convex hull)
+	uint32_t LocateTriangle(const DelaunayMesh& mesh, const glm::vec3& point, uint32_t triangle)
+	{
+		uint32_t entryEdge = DelaunayMesh::INVALID_INDEX;
+
+		for (uint32_t step = 0; step < mesh.NumTriangles(); step++)
+		{
+			uint32_t exitEdge = DelaunayMesh::INVALID_INDEX;
+			for (uint32_t edge = 3 * triangle; edge < 3 * triangle + 3; edge++)
+			{
+				if (	edge != entryEdge
+					&&	Geom2DTest::Orient2D(TestPosition(mesh, mesh.origins[edge]), TestPosition(mesh, mesh.origins[mesh.nexts[edge]]), point) > 0.0)
+				{
+					exitEdge = edge;
+					break;
+				}
+			}
+
+			if (exitEdge == DelaunayMesh::INVALID_INDEX)
+			{
+				return triangle;
+			}
+
+			entryEdge = mesh.twins[exitEdge];
+			if (entryEdge == DelaunayMesh::INVALID_INDEX)
+			{
+				return DelaunayMesh::INVALID_INDEX;
+			}
+
+			triangle = mesh.faces[entryEdge];
+		}
+
+		// the walk only goes around in circles in a triangulation that is not Delaunay (with breaklines), so every triangle
+		// is tested then
+		return FindTriangle(mesh, point);
+	}
+
+	// Circumcenter of the triangle (a, b, c), relative to the origin (computed in double precision)
+	glm::dvec2 Circumcenter(const glm::vec3& origin, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		double ax = (double)a.x - origin.x;
+		double az = (double)a.z - origin.z;
+		double bx = (double)b.x - a.x;
+		double bz = (double)b.z - a.z;
+		double cx = (double)c.x - a.x;
+		double cz = (double)c.z - a.z;
+
+		double b2 = bx * bx + bz * bz;
+		double c2 = cx * cx + cz * cz;
+		double d = 2.0 * (bx * cz - bz * cx);
+
+		return glm::dvec2(ax + (cz * b2 - bz * c2) / d, az + (bx * c2 - cx * b2) / d);
+	}
+
+	// Circumcenter of the mesh triangle, relative to the origin
+	glm::dvec2 Circumcenter(const DelaunayMesh& mesh, const glm::vec3& origin, uint32_t triangle)
+	{
+		return Circumcenter(origin, TestPosition(mesh, mesh.TriangleVertex(triangle, 0)), TestPosition(mesh, mesh.TriangleVertex(triangle, 1)),
+			TestPosition(mesh, mesh.TriangleVertex(triangle, 2)));
+	}
+
+	// Is the point inside the circumcircle of the mesh triangle (clockwise, so (a, c, b) is the order the test expects)
+	bool IsInsideCircumcircle(const DelaunayMesh& mesh, uint32_t triangle, const glm::vec3& point)
+	{
+		return Geom2DTest::InCircle(TestPosition(mesh, mesh.TriangleVertex(triangle, 0)), TestPosition(mesh, mesh.TriangleVertex(triangle, 2)),
+			TestPosition(mesh, mesh.TriangleVertex(triangle, 1)), point) > 0.0;
+	}
+
+	// Natural neighbor (Sibson) interpolation of the height at the point, inside the triangle. The triangles whose
+	// circumcircle contains the point (the cavity it would open) are found first, and then the weight of every vertex of
+	// the cavity boundary is the area its Voronoi cell would give up to the cell of the point: the polygon of the new
+	// Voronoi vertices at both sides of the vertex and the old ones around it inside the cavity. Returns false when the
+	// weights are degenerate (the point is on the convex hull)
+	bool InterpolateNaturalNeighbors(const DelaunayMesh& mesh, const glm::vec3& point, uint32_t triangle, std::vector<uint32_t>& cavity, float& height)
+	{
+		cavity.assign(1, triangle);
+		for (size_t i = 0; i < cavity.size(); i++)
+		{
+			for (uint32_t edge = 3 * cavity[i]; edge < 3 * cavity[i] + 3; edge++)
+			{
+				uint32_t twin = mesh.twins[edge];
+				if (	twin != DelaunayMesh::INVALID_INDEX && std::find(cavity.begin(), cavity.end(), mesh.faces[twin]) == cavity.end()
+					&&	IsInsideCircumcircle(mesh, mesh.faces[twin], point))
+				{
+					cavity.push_back(mesh.faces[twin]);
+				}
+			}
+		}
+
+		auto isBoundary = [&mesh, &cavity](uint32_t edge)
+		{
+			uint32_t twin = mesh.twins[edge];
+			return twin == DelaunayMesh::INVALID_INDEX || std::find(cavity.begin(), cavity.end(), mesh.faces[twin]) == cavity.end();
+		};
+
+		uint32_t firstEdge = DelaunayMesh::INVALID_INDEX;
+		for (size_t i = 0; i < cavity.size() && firstEdge == DelaunayMesh::INVALID_INDEX; i++)
+		{
+			for (uint32_t edge = 3 * cavity[i]; edge < 3 * cavity[i] + 3 && firstEdge == DelaunayMesh::INVALID_INDEX; edge++)
+			{
+				firstEdge = isBoundary(edge) ? edge : firstEdge;
+			}
+		}
+
+		// boundary edges (a, b) in order, each of them followed by the old Voronoi vertices around b inside the cavity
+		double weights = 0.0;
+		double weightedHeights = 0.0;
+
+		uint32_t edge = firstEdge;
+		glm::dvec2 center = Circumcenter(point, point, TestPosition(mesh, mesh.origins[edge]), TestPosition(mesh, mesh.origins[mesh.nexts[edge]]));
+		for (size_t step = 0; step < 3 * cavity.size(); step++)
+		{
+			uint32_t vertex = mesh.origins[mesh.nexts[edge]];
+
+			// the polygon starts at the new Voronoi vertex of the edge, and its area is summed as it goes (shoelace)
+			glm::dvec2 firstCenter = center;
+			double area = 0.0;
+
+			uint32_t nextEdge = mesh.nexts[edge];
+			while (!isBoundary(nextEdge))
+			{
+				glm::dvec2 oldCenter = Circumcenter(mesh, point, mesh.faces[nextEdge]);
+				area += center.x * oldCenter.y - oldCenter.x * center.y;
+				center = oldCenter;
+
+				nextEdge = mesh.nexts[mesh.twins[nextEdge]];
+			}
+
+			glm::dvec2 oldCenter = Circumcenter(mesh, point, mesh.faces[nextEdge]);
+			area += center.x * oldCenter.y - oldCenter.x * center.y;
+
+			center = Circumcenter(point, point, TestPosition(mesh, vertex), TestPosition(mesh, mesh.origins[mesh.nexts[nextEdge]]));
+			area += oldCenter.x * center.y - center.x * oldCenter.y;
+			area += center.x * firstCenter.y - firstCenter.x * center.y;
+
+			weights += std::abs(area);
+			weightedHeights += std::abs(area) * mesh.heights[vertex];
+
+			edge = nextEdge;
+			if (edge == firstEdge)
+			{
+				break;
+			}
+		}
+
+		if (!(weights > 0.0) || !std::isfinite(weightedHeights))
+		{
+			return false;
+		}
+
+		height = (float)(weightedHeights / weights);
+
+		return true;
+	}
+
+	// Interpolate the height at the point, in the triangle of the result, from the orientation of the triangle (area) and
+	// the ones of the triangles with the point in place of its first and its second vertex
+	void Interpolate(const DelaunayMesh& mesh, const glm::vec3& point, double area, double sideA, double sideB, DelaunayInterpolation interpolation,
+		std::vector<uint32_t>& cavity, DelaunayQueryResult& result)
+	{
+		uint32_t a = mesh.TriangleVertex(result.triangle, 0);
+		uint32_t b = mesh.TriangleVertex(result.triangle, 1);
+		uint32_t c = mesh.TriangleVertex(result.triangle, 2);
+
+		double weightA = sideA / area;
+		double weightB = sideB / area;
+
+		result.barycentric = glm::vec3((float)weightA, (float)weightB, (float)(1.0 - weightA - weightB));
+		result.height = result.barycentric.x * mesh.heights[a] + result.barycentric.y * mesh.heights[b] + result.barycentric.z * mesh.heights[c];
+
+		// at a vertex the natural neighbors are the vertex alone
+		bool atVertex = result.barycentric.x == 1.0f || result.barycentric.y == 1.0f || result.barycentric.z == 1.0f;
+		if (interpolation == DelaunayInterpolation::NATURAL_NEIGHBOR && !atVertex)
+		{
+			InterpolateNaturalNeighbors(mesh, point, result.triangle, cavity, result.height);
+		}
+	}
+
+	// Result of a query outside the triangulation
+	void SetOutside(DelaunayQueryResult& result)
+	{
+		result.triangle = DelaunayMesh::INVALID_INDEX;
+		result.barycentric = glm::vec3(0.0f);
+		result.height = 0.0f;
+	}
+
+	// Query the mesh at the position, walking from the triangle given
+	void Query(const DelaunayMesh& mesh, const glm::vec2& position, uint32_t startTriangle, DelaunayInterpolation interpolation, std::vector<uint32_t>& cavity, DelaunayQueryResult& result)
+	{
+		glm::vec3 point(position.x, 0.0f, position.y);
+
+		result.triangle = LocateTriangle(mesh, point, startTriangle);
+		if (result.triangle == DelaunayMesh::INVALID_INDEX)
+		{
+			SetOutside(result);
+			return;
+		}
+
+		glm::vec3 a = TestPosition(mesh, mesh.TriangleVertex(result.triangle, 0));
+		glm::vec3 b = TestPosition(mesh, mesh.TriangleVertex(result.triangle, 1));
+		glm::vec3 c = TestPosition(mesh, mesh.TriangleVertex(result.triangle, 2));
+
+		Interpolate(mesh, point, Geom2DTest::Orient2D(a, b, c), Geom2DTest::Orient2D(point, b, c), Geom2DTest::Orient2D(a, point, c), interpolation, cavity, result);
+	}
+
+	// Query the mesh at a batch of positions (x, z). The batch is split in blocks that are queried in parallel, and the
+	// walk of every query starts at the triangle of the previous one of its block, so batches with some spatial coherence
+	// (like the samples of a grid or a path) walk only a few triangles per query. Each block locates its queries a chunk at
+	// a time (the walks depend on each other), and then the orientations that give the barycentric coordinates of the
+	// chunk are computed in batches
+	void Query(const DelaunayMesh& mesh, const glm::vec2* positions, size_t numPositions, DelaunayInterpolation interpolation, DelaunayQueryResult* results)
+	{
+		if (mesh.NumTriangles() == 0)
+		{
+			std::fill(results, results + numPositions, DelaunayQueryResult());
+			return;
+		}
+
+		const size_t minBlockSize = 1 << 10;
+		const size_t chunkSize = 256;
+
+		Parallel::ForBlocks(0, numPositions, minBlockSize, [&](size_t blockBegin, size_t blockEnd, size_t)
+		{
+			std::vector<uint32_t> cavity;
+			uint32_t triangle = mesh.NumTriangles() / 2;
+
+			// x and z of the position and of the vertices of the triangle of every query located in the chunk
+			std::vector<float> coordinates(8 * chunkSize);
+			Geom2DBatch::Points points[4];
+			for (int i = 0; i < 4; i++)
+			{
+				points[i] = { &coordinates[2 * i * chunkSize], &coordinates[(2 * i + 1) * chunkSize] };
+			}
+
+			std::vector<size_t> located;
+			std::vector<double> orientations(3 * chunkSize);
+			double* areas = &orientations[0];
+			double* sidesA = &orientations[chunkSize];
+			double* sidesB = &orientations[2 * chunkSize];
+
+			for (size_t chunkBegin = blockBegin; chunkBegin < blockEnd; chunkBegin += chunkSize)
+			{
+				size_t chunkEnd = std::min(blockEnd, chunkBegin + chunkSize);
+
+				located.clear();
+				for (size_t i = chunkBegin; i < chunkEnd; i++)
+				{
+					results[i].triangle = LocateTriangle(mesh, glm::vec3(positions[i].x, 0.0f, positions[i].y), triangle);
+					if (results[i].triangle == DelaunayMesh::INVALID_INDEX)
+					{
+						SetOutside(results[i]);
+						continue;
+					}
+
+					triangle = results[i].triangle;
+
+					size_t k = located.size();
+					coordinates[k] = positions[i].x;
+					coordinates[chunkSize + k] = positions[i].y;
+					for (uint32_t vertex = 0; vertex < 3; vertex++)
+					{
+						const glm::vec2& position = mesh.positions[mesh.TriangleVertex(triangle, vertex)];
+						coordinates[(2 * vertex + 2) * chunkSize + k] = position.x;
+						coordinates[(2 * vertex + 3) * chunkSize + k] = position.y;
+					}
+
+					located.push_back(i);
+				}
+
+				Geom2DBatch::Orient2D(points[1], points[2], points[3], located.size(), areas);
+				Geom2DBatch::Orient2D(points[0], points[2], points[3], located.size(), sidesA);
+				Geom2DBatch::Orient2D(points[1], points[0], points[3], located.size(), sidesB);
+
+				for (size_t k = 0; k < located.size(); k++)
+				{
+					size_t i = located[k];
+					Interpolate(mesh, glm::vec3(positions[i].x, 0.0f, positions[i].y), areas[k], sidesA[k], sidesB[k], interpolation, cavity, results[i]);
+				}
+			}
+		});
+	}
+}
+
+#endif // !DELAUNAY_QUERY_H
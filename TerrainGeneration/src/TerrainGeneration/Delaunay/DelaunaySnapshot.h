@@ -0,0 +1,148 @@
+#ifndef DELAUNAY_SNAPSHOT_H
+#define DELAUNAY_SNAPSHOT_H
+
+#include "glm/glm.hpp"
+#include "../../Parallel/Parallel.h"
+#include "DelaunayMesh.h"
+
+#include <cstdint>
+#include <vector>
+
+// Binary snapshot of a triangulation (Delaunay::SaveSnapshot): the header and then its arrays one after another, in the
+// byte order of the machine
+//
+//	glm::vec3	positions[numVertices]			vertex (x, height, z)
+//	uint32_t	vertexEdges[numVertices]		a half-edge whose origin is the vertex
+//	uint32_t	origins[3 * numTriangles]		vertex where the half-edge starts
+//	uint32_t	twins[3 * numTriangles]			matching half-edge of the opposing triangle (INVALID_INDEX on the boundary)
+//	uint8_t		constrained[3 * numTriangles]	the half-edge is part of a breakline
+//
+// Triangle t owns the half-edges 3t, 3t + 1 and 3t + 2 as in the mesh, so the nexts and the faces are implied. The first
+// vertices and triangles are the ones of the mesh, in its order, and the rest are the vertices of the root triangle and
+// the triangles that use them, which only a live triangulation has (the root vertices are INVALID_INDEX without it)
+struct DelaunaySnapshotHeader
+{
+	static const uint32_t MAGIC = 0x4E495444;	// "DTIN"
+	static const uint32_t VERSION = 1;
+
+	uint32_t magic = MAGIC;
+	uint32_t version = VERSION;
+
+	// vertices and triangles, and how many of them are the ones of the mesh
+	uint32_t numVertices = 0;
+	uint32_t numTriangles = 0;
+	uint32_t numMeshVertices = 0;
+	uint32_t numMeshTriangles = 0;
+
+	// vertices of the root triangle
+	uint32_t rootVertices[3] = { DelaunayMesh::INVALID_INDEX, DelaunayMesh::INVALID_INDEX, DelaunayMesh::INVALID_INDEX };
+
+	// scale of the lattice of the integer coordinates (0 without them)
+	float latticeScale = 0.0f;
+
+	// Is the snapshot of a live triangulation
+	bool IsLive() const { return rootVertices[0] != DelaunayMesh::INVALID_INDEX; }
+
+	// offsets of the arrays (in bytes from the start of the file), which all end up aligned to 4 bytes
+	size_t PositionsOffset() const { return sizeof(DelaunaySnapshotHeader); }
+	size_t VertexEdgesOffset() const { return PositionsOffset() + (size_t)numVertices * sizeof(glm::vec3); }
+	size_t OriginsOffset() const { return VertexEdgesOffset() + (size_t)numVertices * sizeof(uint32_t); }
+	size_t TwinsOffset() const { return OriginsOffset() + 3 * (size_t)numTriangles * sizeof(uint32_t); }
+	size_t ConstrainedOffset() const { return TwinsOffset() + 3 * (size_t)numTriangles * sizeof(uint32_t); }
+	size_t FileSize() const { return ConstrainedOffset() + 3 * (size_t)numTriangles * sizeof(uint8_t); }
+};
+
+namespace DelaunaySnapshot
+{
+	// Is the snapshot in the buffer (the whole file) well formed: the header matches the size of the file, every index is
+	// in range, every pair of twins is symmetric and joins the same two vertices, and the half-edges of the vertices start at
+	// them, so the triangulation can be restored from it without checking anything else. The indices are checked in parallel
+	bool IsValid(const char* buffer, size_t size)
+	{
+		if (size < sizeof(DelaunaySnapshotHeader))
+		{
+			return false;
+		}
+
+		const DelaunaySnapshotHeader& header = *reinterpret_cast<const DelaunaySnapshotHeader*>(buffer);
+		if (header.magic != DelaunaySnapshotHeader::MAGIC || header.version != DelaunaySnapshotHeader::VERSION)
+		{
+			return false;
+		}
+
+		// the half-edges are indexed with 32 bits
+		uint64_t numHalfEdges = 3 * (uint64_t)header.numTriangles;
+		if (numHalfEdges >= DelaunayMesh::INVALID_INDEX || header.FileSize() != size
+			|| header.numMeshVertices > header.numVertices || header.numMeshTriangles > header.numTriangles)
+		{
+			return false;
+		}
+
+		// a live triangulation has its root vertices and at least a triangle
+		if (header.IsLive())
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				if (header.rootVertices[i] >= header.numVertices)
+				{
+					return false;
+				}
+			}
+
+			if (header.numTriangles == 0)
+			{
+				return false;
+			}
+		}
+
+		const uint32_t* vertexEdges = reinterpret_cast<const uint32_t*>(buffer + header.VertexEdgesOffset());
+		const uint32_t* origins = reinterpret_cast<const uint32_t*>(buffer + header.OriginsOffset());
+		const uint32_t* twins = reinterpret_cast<const uint32_t*>(buffer + header.TwinsOffset());
+
+		std::vector<uint8_t> valid(Parallel::NumThreads(), 1);
+
+		Parallel::ForBlocks(0, (size_t)numHalfEdges, 1 << 16, [&](size_t blockBegin, size_t blockEnd, size_t block)
+		{
+			for (size_t edge = blockBegin; edge < blockEnd; edge++)
+			{
+				// the twin runs the other way, so it starts where the next half-edge of the triangle does
+				uint32_t twin = twins[edge];
+				size_t next = edge % 3 == 2 ? edge - 2 : edge + 1;
+				if (origins[edge] >= header.numVertices || (twin != DelaunayMesh::INVALID_INDEX
+					&& (twin >= numHalfEdges || twins[twin] != edge || origins[twin] != origins[next])))
+				{
+					valid[block] = 0;
+					return;
+				}
+			}
+		});
+
+		// only a live triangulation needs the half-edges of the vertices
+		if (header.IsLive())
+		{
+			Parallel::ForBlocks(0, header.numVertices, 1 << 16, [&](size_t blockBegin, size_t blockEnd, size_t block)
+			{
+				for (size_t vertex = blockBegin; vertex < blockEnd; vertex++)
+				{
+					if (vertexEdges[vertex] >= numHalfEdges || origins[vertexEdges[vertex]] != vertex)
+					{
+						valid[block] = 0;
+						return;
+					}
+				}
+			});
+		}
+
+		for (uint8_t blockValid : valid)
+		{
+			if (!blockValid)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+#endif // !DELAUNAY_SNAPSHOT_H
@@ -0,0 +1,107 @@
+#ifndef DELAUNAY_STATS_H
+#define DELAUNAY_STATS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+// Instrumentation of the triangulation, on unless DELAUNAY_STATS is defined as 0 (then the counters and the timers compile
+// to nothing and the statistics stay at zero). The legalization is timed point by point, which reads the clock twice per
+// point inserted (a few percent of the insertion)
+#ifndef DELAUNAY_STATS
+#define DELAUNAY_STATS 1
+#endif
+
+// Statistics of the triangulation since it was last cleared: what the algorithm did, how big the pools got and the time
+// spent in each phase
+struct DelaunayStats
+{
+	// triangles walked (or history DAG nodes visited) to locate the points
+	uint64_t locationSteps = 0;
+
+	// points the location could not place (left out of the triangulation)
+	uint64_t failedLocations = 0;
+
+	// in circle tests of the legality of an edge (or of whether a triangle is in the cavity of a point, in parallel)
+	uint64_t inCircleTests = 0;
+
+	// edges flipped
+	uint64_t flips = 0;
+
+	// most objects handed out by the pools at once
+	size_t peakTriangles = 0;
+	size_t peakEdges = 0;
+	size_t peakVertices = 0;
+
+	// time of each phase, in milliseconds. The legalization happens during the insertion, so its time is part of the
+	// insertion time too, and the one shot engines count as insertion as a whole
+	double rootTriangleTime = 0.0;
+	double insertionTime = 0.0;
+	double legalizationTime = 0.0;
+	double extractionTime = 0.0;
+
+	// Clear
+	void Clear()
+	{
+		*this = DelaunayStats();
+	}
+
+	// Add the counters and the times of other statistics (of another worker thread), keeping the largest peaks
+	void Add(const DelaunayStats& other)
+	{
+		locationSteps += other.locationSteps;
+		failedLocations += other.failedLocations;
+		inCircleTests += other.inCircleTests;
+		flips += other.flips;
+
+		peakTriangles = std::max(peakTriangles, other.peakTriangles);
+		peakEdges = std::max(peakEdges, other.peakEdges);
+		peakVertices = std::max(peakVertices, other.peakVertices);
+
+		rootTriangleTime += other.rootTriangleTime;
+		insertionTime += other.insertionTime;
+		legalizationTime += other.legalizationTime;
+		extractionTime += other.extractionTime;
+	}
+
+	// JSON object with the statistics
+	std::string ToJson() const
+	{
+		std::ostringstream json;
+		json << "{\n"
+			<< "  \"enabled\": " << (DELAUNAY_STATS ? "true" : "false") << ",\n"
+			<< "  \"locationSteps\": " << locationSteps << ",\n"
+			<< "  \"failedLocations\": " << failedLocations << ",\n"
+			<< "  \"inCircleTests\": " << inCircleTests << ",\n"
+			<< "  \"flips\": " << flips << ",\n"
+			<< "  \"peakPoolUsage\": { \"triangles\": " << peakTriangles << ", \"edges\": " << peakEdges << ", \"vertices\": " << peakVertices << " },\n"
+			<< "  \"phaseTimesMs\": { \"rootTriangle\": " << rootTriangleTime << ", \"insertion\": " << insertionTime
+			<< ", \"legalization\": " << legalizationTime << ", \"extraction\": " << extractionTime << " }\n"
+			<< "}\n";
+
+		return json.str();
+	}
+};
+
+// Adds the time from its construction to its destruction to the phase time given (in milliseconds)
+class DelaunayStatsTimer
+{
+	double& phaseTime;
+	std::chrono::steady_clock::time_point start;
+
+public:
+	DelaunayStatsTimer(double& time) : phaseTime(time), start(std::chrono::steady_clock::now()) {}
+	~DelaunayStatsTimer() { phaseTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(); }
+};
+
+#if DELAUNAY_STATS
+#define DELAUNAY_STATS_COUNT(counter, count) ((counter) += (count))
+#define DELAUNAY_STATS_TIMER(phaseTime) DelaunayStatsTimer phaseTimer(phaseTime)
+#else
+#define DELAUNAY_STATS_COUNT(counter, count) ((void)0)
+#define DELAUNAY_STATS_TIMER(phaseTime) ((void)0)
+#endif
+
+#endif // !DELAUNAY_STATS_H
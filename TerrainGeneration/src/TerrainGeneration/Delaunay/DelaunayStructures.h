@@ -2,6 +2,9 @@
 #define DELAUNAY_STRUCTURES_H
 
 #include "glm/glm.hpp"
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 
 struct DelaunayTriangle;
@@ -15,7 +18,7 @@ struct DelaunayVertex
 	// edge whose origin is v
 	DelaunayEdge* edge = nullptr; 
 
-	// Index used to when exporting the vertex
+	// Index used when exporting the vertex
 	int exportIndex = -1;
 
 	void Clear()
@@ -39,34 +42,76 @@ struct DelaunayEdge
 	// the face connected to this half edge
 	DelaunayTriangle* face = nullptr; 
 
+	// the edge is part of a breakline, so it is never flipped (both half-edges are flagged)
+	bool constrained = false;
+
 	void Clear()
 	{
 		twin = nullptr;
 		next = nullptr;
 		v = nullptr;
 		face = nullptr;
+		constrained = false;
 	}
 };
 
 struct DelaunayTriangle
 {
+	// a triangle gets 3 children when it is split and 2 when one of its edges is flipped
+	static const int MAX_CHILDREN = 3;
+
 	// edge belonging to the triangle
-	DelaunayEdge* edge;
+	DelaunayEdge* edge = nullptr;
 
-	// vertices (This is mainly for debugging purpose)
-	glm::vec3 v1, v2, v3;
+	// Index used when exporting the triangle
+	int exportIndex = -1;
 
 	// parent and children
 	DelaunayTriangle* parent = nullptr;
-	std::vector< DelaunayTriangle* > children;
+	DelaunayTriangle* children[MAX_CHILDREN];
+	int numChildren = 0;
+
+	// slot of the lock of the triangle during the parallel insertion (the locks live apart, so the triangle stays a plain
+	// struct; see Delaunay::TryLockTriangle)
+	uint32_t lockSlot = 0;
+
+	// Is leaf
+	bool IsLeaf() const { return numChildren == 0; }
+
+	// Add child
+	void AddChild(DelaunayTriangle* child)
+	{
+		assert(numChildren < MAX_CHILDREN);
+		children[numChildren++] = child;
+	}
+
+	// Remove child
+	void RemoveChild(DelaunayTriangle* child)
+	{
+		for (int i = 0; i < numChildren; i++)
+		{
+			if (children[i] == child)
+			{
+				children[i] = children[--numChildren];
+				return;
+			}
+		}
+
+		assert(false);
+	}
 
 	// Clear
 	void Clear()
 	{
 		parent = nullptr;
-		children.clear();
+		numChildren = 0;
 		edge = nullptr;
+		exportIndex = -1;
 	}
 };
 
+// the structures of the pools stay plain structs, so they can be copied as memory
+static_assert(std::is_trivially_copyable<DelaunayVertex>::value && std::is_trivially_copyable<DelaunayEdge>::value
+	&& std::is_trivially_copyable<DelaunayTriangle>::value, "the Delaunay structures must stay trivially copyable");
+
 #endif // !DELAUNAY_STRUCTURES_H
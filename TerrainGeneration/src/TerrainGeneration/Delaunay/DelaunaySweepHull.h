@@ -0,0 +1,553 @@
+#ifndef DELAUNAY_SWEEP_HULL_H
+#define DELAUNAY_SWEEP_HULL_H
+
+#include "../../Geom2DTest/Geom2DTest.h"
+#include "DelaunayEngine.h"
+#include "DelaunayInsertionOrder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Radial sweep-hull Delaunay triangulation (the algorithm of Delaunator).
+//
+// Starting from a small seed triangle near the middle of the points, the points are added in order of their distance to
+// the circumcenter of the seed. Every new point lies outside the convex hull built so far, so it is connected to the hull
+// edges it can see (found through a hash of the hull by angle around the center) and the new triangles are legalized by
+// flipping. The triangles are written straight into the origins and twins of the mesh
+class DelaunaySweepHull : public DelaunayEngine
+{
+	static const uint32_t INVALID_INDEX = DelaunayMesh::INVALID_INDEX;
+
+	// order of the points by distance to the center
+	std::vector<uint32_t> ids;
+	std::vector<double> distances;
+
+	// convex hull (clockwise in the xz plane) as a linked list of points, with the triangle edge lying on each hull edge
+	std::vector<uint32_t> hullNext;
+	std::vector<uint32_t> hullPrev;
+	std::vector<uint32_t> hullTriangle;
+	uint32_t hullStart = INVALID_INDEX;
+
+	// hull points by angle around the center
+	std::vector<uint32_t> hullHash;
+	double centerX = 0.0;
+	double centerZ = 0.0;
+
+	// work stack of the edges pending legalization
+	std::vector<uint32_t> edgesToLegalize;
+
+	// mesh being built
+	DelaunayMesh* mesh = nullptr;
+	uint32_t numHalfEdges = 0;
+
+	// new index of every vertex kept (INVALID_INDEX for the duplicated points removed)
+	std::vector<uint32_t> vertexIndices;
+
+public:
+
+	DelaunaySweepHull() {}
+	~DelaunaySweepHull() {}
+
+	// Triangulate the points into the mesh (the vertices of the mesh are the points without the duplicated ones, in the
+	// same order)
+	void Triangulate(const std::vector<glm::vec3>& points, DelaunayMesh& mesh) override
+	{
+		mesh.Clear();
+		for (auto& point : points)
+		{
+			mesh.AddVertex(point);
+		}
+
+		uint32_t numPoints = (uint32_t)points.size();
+		if (numPoints < 3)
+		{
+			RemoveDuplicatedVertices(points, mesh);
+			return;
+		}
+
+		uint32_t i0, i1, i2;
+		if (!FindSeedTriangle(points, i0, i1, i2))
+		{
+			// all the points are collinear
+			RemoveDuplicatedVertices(points, mesh);
+			return;
+		}
+
+		this->mesh = &mesh;
+		numHalfEdges = 0;
+
+		uint32_t maxTriangles = 2 * numPoints - 5;
+		mesh.origins.resize(3 * maxTriangles);
+		mesh.twins.resize(3 * maxTriangles);
+
+		SortPointsByDistance(points);
+
+		InitHull(points, i0, i1, i2);
+
+		AddTriangle(i0, i1, i2, INVALID_INDEX, INVALID_INDEX, INVALID_INDEX);
+
+		const glm::vec3* previous = nullptr;
+		for (auto i : ids)
+		{
+			const glm::vec3& point = points[i];
+
+			// skip the duplicated points (equal points are next to each other in the order, unless another point lies
+			// at the same distance; those are skipped below as no hull edge is visible from them)
+			if (previous && previous->x == point.x && previous->z == point.z)
+			{
+				continue;
+			}
+			previous = &point;
+
+			if (i == i0 || i == i1 || i == i2)
+			{
+				continue;
+			}
+
+			AddPoint(points, i);
+		}
+
+		mesh.origins.resize(numHalfEdges);
+		mesh.twins.resize(numHalfEdges);
+		mesh.LinkTriangles();
+
+		// the duplicated points were skipped, so no triangle uses them
+		RemoveUnusedVertices(mesh);
+
+		this->mesh = nullptr;
+	}
+
+	// Release the memory used by the triangulation
+	void ReleaseMemory() override
+	{
+		ids = std::vector<uint32_t>();
+		distances = std::vector<double>();
+		hullNext = std::vector<uint32_t>();
+		hullPrev = std::vector<uint32_t>();
+		hullTriangle = std::vector<uint32_t>();
+		hullHash = std::vector<uint32_t>();
+		edgesToLegalize = std::vector<uint32_t>();
+		vertexIndices = std::vector<uint32_t>();
+	}
+
+private:
+
+	// Remove the vertices that no triangle uses (the duplicated points)
+	void RemoveUnusedVertices(DelaunayMesh& mesh)
+	{
+		vertexIndices.assign(mesh.NumVertices(), INVALID_INDEX);
+		for (uint32_t edge = 0; edge < mesh.NumHalfEdges(); edge++)
+		{
+			vertexIndices[mesh.origins[edge]] = 0;
+		}
+
+		CompactVertices(mesh);
+	}
+
+	// Remove the duplicated points from the vertices of a mesh without triangles (fewer than 3 points, or all of them
+	// collinear), keeping the first of the equal ones
+	void RemoveDuplicatedVertices(const std::vector<glm::vec3>& points, DelaunayMesh& mesh)
+	{
+		std::vector<uint32_t> order;
+		SpatialSort::LexicographicOrder(points, order);
+
+		vertexIndices.assign(mesh.NumVertices(), INVALID_INDEX);
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			const glm::vec3& point = points[order[i]];
+			if (i == 0 || points[order[i - 1]].x != point.x || points[order[i - 1]].z != point.z)
+			{
+				vertexIndices[order[i]] = 0;
+			}
+		}
+
+		CompactVertices(mesh);
+	}
+
+	// Keep the vertices marked in vertexIndices (not INVALID_INDEX) in the same order, numbering them and renumbering
+	// the origins of the half-edges
+	void CompactVertices(DelaunayMesh& mesh)
+	{
+		uint32_t numVertices = 0;
+		for (uint32_t vertex = 0; vertex < mesh.NumVertices(); vertex++)
+		{
+			if (vertexIndices[vertex] != INVALID_INDEX)
+			{
+				vertexIndices[vertex] = numVertices;
+				mesh.positions[numVertices] = mesh.positions[vertex];
+				mesh.heights[numVertices] = mesh.heights[vertex];
+				numVertices++;
+			}
+		}
+
+		if (numVertices == mesh.NumVertices())
+		{
+			return;
+		}
+
+		mesh.positions.resize(numVertices);
+		mesh.heights.resize(numVertices);
+
+		for (auto& origin : mesh.origins)
+		{
+			origin = vertexIndices[origin];
+		}
+	}
+
+	// Find the seed triangle: the point closest to the center of the bounding box, the point closest to it and the point
+	// that makes the smallest circumcircle with both. Returns false when all the points are collinear
+	bool FindSeedTriangle(const std::vector<glm::vec3>& points, uint32_t& i0, uint32_t& i1, uint32_t& i2)
+	{
+		uint32_t numPoints = (uint32_t)points.size();
+
+		glm::vec3 minPoint = points[0];
+		glm::vec3 maxPoint = points[0];
+		for (auto& point : points)
+		{
+			minPoint = glm::min(minPoint, point);
+			maxPoint = glm::max(maxPoint, point);
+		}
+
+		double middleX = 0.5 * ((double)minPoint.x + maxPoint.x);
+		double middleZ = 0.5 * ((double)minPoint.z + maxPoint.z);
+
+		i0 = ClosestPoint(points, middleX, middleZ, false);
+		i1 = ClosestPoint(points, points[i0].x, points[i0].z, true);
+		if (i1 == INVALID_INDEX)
+		{
+			return false;
+		}
+
+		double minRadius = std::numeric_limits<double>::infinity();
+		i2 = INVALID_INDEX;
+		for (uint32_t i = 0; i < numPoints; i++)
+		{
+			if (i == i0 || i == i1 || Geom2DTest::Orient2D(points[i0], points[i1], points[i]) == 0.0)
+			{
+				continue;
+			}
+
+			double x, z;
+			double radius = Circumcircle(points[i0], points[i1], points[i], x, z);
+			if (radius < minRadius)
+			{
+				minRadius = radius;
+				i2 = i;
+			}
+		}
+
+		if (i2 == INVALID_INDEX)
+		{
+			return false;
+		}
+
+		// clockwise, as the rest of the triangles
+		if (Geom2DTest::Orient2D(points[i0], points[i1], points[i2]) > 0.0)
+		{
+			std::swap(i1, i2);
+		}
+
+		Circumcircle(points[i0], points[i1], points[i2], centerX, centerZ);
+
+		return true;
+	}
+
+	// Closest point to (x, z), optionally skipping the points that lie at (x, z)
+	uint32_t ClosestPoint(const std::vector<glm::vec3>& points, double x, double z, bool skipCoincident) const
+	{
+		uint32_t closest = INVALID_INDEX;
+		double minDistance = std::numeric_limits<double>::infinity();
+
+		for (uint32_t i = 0; i < (uint32_t)points.size(); i++)
+		{
+			double distance = SqrDistance(points[i], x, z);
+			if (distance < minDistance && (!skipCoincident || distance > 0.0))
+			{
+				minDistance = distance;
+				closest = i;
+			}
+		}
+
+		return closest;
+	}
+
+	// Sort the points by their distance to the center
+	void SortPointsByDistance(const std::vector<glm::vec3>& points)
+	{
+		uint32_t numPoints = (uint32_t)points.size();
+
+		distances.resize(numPoints);
+		for (uint32_t i = 0; i < numPoints; i++)
+		{
+			distances[i] = SqrDistance(points[i], centerX, centerZ);
+		}
+
+		ids.resize(numPoints);
+		for (uint32_t i = 0; i < numPoints; i++)
+		{
+			ids[i] = i;
+		}
+
+		std::sort(ids.begin(), ids.end(), [this](uint32_t a, uint32_t b)
+		{
+			return distances[a] < distances[b] || (distances[a] == distances[b] && a < b);
+		});
+	}
+
+	// Init the hull with the seed triangle
+	void InitHull(const std::vector<glm::vec3>& points, uint32_t i0, uint32_t i1, uint32_t i2)
+	{
+		uint32_t numPoints = (uint32_t)points.size();
+
+		hullNext.resize(numPoints);
+		hullPrev.resize(numPoints);
+		hullTriangle.resize(numPoints);
+
+		hullStart = i0;
+
+		hullNext[i0] = hullPrev[i2] = i1;
+		hullNext[i1] = hullPrev[i0] = i2;
+		hullNext[i2] = hullPrev[i1] = i0;
+
+		hullTriangle[i0] = 0;
+		hullTriangle[i1] = 1;
+		hullTriangle[i2] = 2;
+
+		hullHash.assign((size_t)std::ceil(std::sqrt((double)numPoints)), INVALID_INDEX);
+		hullHash[HashKey(points[i0])] = i0;
+		hullHash[HashKey(points[i1])] = i1;
+		hullHash[HashKey(points[i2])] = i2;
+	}
+
+	// Add point to triangulation
+	void AddPoint(const std::vector<glm::vec3>& points, uint32_t i)
+	{
+		const glm::vec3& point = points[i];
+
+		// find a hull edge visible from the point, starting from the hull point closest by angle
+		uint32_t start = INVALID_INDEX;
+		uint32_t key = HashKey(point);
+		for (size_t j = 0; j < hullHash.size(); j++)
+		{
+			start = hullHash[(key + j) % hullHash.size()];
+			if (start != INVALID_INDEX && start != hullNext[start])
+			{
+				break;
+			}
+		}
+
+		start = hullPrev[start];
+		uint32_t e = start;
+		while (Geom2DTest::Orient2D(point, points[e], points[hullNext[e]]) <= 0.0)
+		{
+			e = hullNext[e];
+			if (e == start)
+			{
+				// no visible edge, so the point is a duplicate of one already in the triangulation
+				return;
+			}
+		}
+
+		// first triangle from the point
+		uint32_t t = AddTriangle(e, i, hullNext[e], INVALID_INDEX, INVALID_INDEX, hullTriangle[e]);
+		hullTriangle[i] = LegalizeEdges(points, t + 2);
+		hullTriangle[e] = t;
+
+		// walk forward through the hull, adding triangles while the edges are visible
+		uint32_t n = hullNext[e];
+		uint32_t q = hullNext[n];
+		while (Geom2DTest::Orient2D(point, points[n], points[q]) > 0.0)
+		{
+			t = AddTriangle(n, i, q, hullTriangle[i], INVALID_INDEX, hullTriangle[n]);
+			hullTriangle[i] = LegalizeEdges(points, t + 2);
+			hullNext[n] = n; // removed from the hull
+			n = q;
+			q = hullNext[n];
+		}
+
+		// walk backward from the other side, adding triangles while the edges are visible
+		if (e == start)
+		{
+			q = hullPrev[e];
+			while (Geom2DTest::Orient2D(point, points[q], points[e]) > 0.0)
+			{
+				t = AddTriangle(q, i, e, INVALID_INDEX, hullTriangle[e], hullTriangle[q]);
+				LegalizeEdges(points, t + 2);
+				hullTriangle[q] = t;
+				hullNext[e] = e; // removed from the hull
+				e = q;
+				q = hullPrev[e];
+			}
+		}
+
+		// update the hull
+		hullStart = hullPrev[i] = e;
+		hullNext[e] = hullPrev[n] = i;
+		hullNext[i] = n;
+
+		hullHash[HashKey(point)] = i;
+		hullHash[HashKey(points[e])] = e;
+	}
+
+	// Add triangle (i0, i1, i2) whose half-edges have the twins a, b and c. Returns its first half-edge
+	uint32_t AddTriangle(uint32_t i0, uint32_t i1, uint32_t i2, uint32_t a, uint32_t b, uint32_t c)
+	{
+		uint32_t t = numHalfEdges;
+
+		mesh->origins[t] = i0;
+		mesh->origins[t + 1] = i1;
+		mesh->origins[t + 2] = i2;
+
+		Link(t, a);
+		Link(t + 1, b);
+		Link(t + 2, c);
+
+		numHalfEdges += 3;
+
+		return t;
+	}
+
+	// Set the half-edges a and b as twins
+	void Link(uint32_t a, uint32_t b)
+	{
+		mesh->twins[a] = b;
+		if (b != INVALID_INDEX)
+		{
+			mesh->twins[b] = a;
+		}
+	}
+
+	// Legalize the edge, flipping it (and then the edges beyond it) while they are illegal. Returns the half-edge before
+	// the last edge tested in its triangle, which is the hull edge out of the new point when legalizing its first triangle
+	uint32_t LegalizeEdges(const std::vector<glm::vec3>& points, uint32_t a)
+	{
+		std::vector<uint32_t>& origins = mesh->origins;
+		std::vector<uint32_t>& twins = mesh->twins;
+
+		uint32_t ar = 0;
+		for (;;)
+		{
+			uint32_t b = twins[a];
+
+			// the edge a, from pr to pl, is shared by the triangles (p0, pr, pl) and (pl, pr, p1). Flipping it leaves the
+			// triangles (p1, pl, p0) and (p0, pr, p1)
+			uint32_t a0 = a - a % 3;
+			ar = a0 + (a + 2) % 3;
+
+			if (b == INVALID_INDEX)
+			{
+				if (edgesToLegalize.empty())
+				{
+					break;
+				}
+				a = edgesToLegalize.back();
+				edgesToLegalize.pop_back();
+				continue;
+			}
+
+			uint32_t b0 = b - b % 3;
+			uint32_t al = a0 + (a + 1) % 3;
+			uint32_t bl = b0 + (b + 2) % 3;
+
+			uint32_t p0 = origins[ar];
+			uint32_t pr = origins[a];
+			uint32_t pl = origins[al];
+			uint32_t p1 = origins[bl];
+
+			// (p0, pr, pl) is clockwise, so it is reversed for the in circle test
+			if (Geom2DTest::InCircle(points[p0], points[pl], points[pr], points[p1]) > 0.0)
+			{
+				origins[a] = p1;
+				origins[b] = p0;
+
+				// the edge flipped was on the other side of the hull (rare), so fix the hull triangle that referenced it
+				uint32_t hbl = twins[bl];
+				if (hbl == INVALID_INDEX)
+				{
+					uint32_t e = hullStart;
+					do
+					{
+						if (hullTriangle[e] == bl)
+						{
+							hullTriangle[e] = a;
+							break;
+						}
+						e = hullPrev[e];
+					} while (e != hullStart);
+				}
+
+				Link(a, hbl);
+				Link(b, twins[ar]);
+				Link(ar, bl);
+
+				edgesToLegalize.push_back(b0 + (b + 1) % 3);
+			}
+			else
+			{
+				if (edgesToLegalize.empty())
+				{
+					break;
+				}
+				a = edgesToLegalize.back();
+				edgesToLegalize.pop_back();
+			}
+		}
+
+		return ar;
+	}
+
+	// Hash key of a point, by its pseudo angle around the center
+	uint32_t HashKey(const glm::vec3& point) const
+	{
+		double dx = point.x - centerX;
+		double dz = point.z - centerZ;
+		if (dx == 0.0 && dz == 0.0)
+		{
+			return 0;
+		}
+
+		// monotonic with the angle, in [0, 1]
+		double p = dx / (std::abs(dx) + std::abs(dz));
+		double angle = (dz > 0.0 ? 3.0 - p : 1.0 + p) / 4.0;
+
+		size_t hashSize = hullHash.size();
+		return (uint32_t)((size_t)std::floor(angle * hashSize) % hashSize);
+	}
+
+	// Square distance from the point to (x, z)
+	static double SqrDistance(const glm::vec3& point, double x, double z)
+	{
+		double dx = point.x - x;
+		double dz = point.z - z;
+
+		return dx * dx + dz * dz;
+	}
+
+	// Circumcircle of the triangle (a, b, c): returns the square radius and sets the center
+	static double Circumcircle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, double& x, double& z)
+	{
+		double bx = (double)b.x - a.x;
+		double bz = (double)b.z - a.z;
+		double cx = (double)c.x - a.x;
+		double cz = (double)c.z - a.z;
+
+		double bl = bx * bx + bz * bz;
+		double cl = cx * cx + cz * cz;
+		double d = 0.5 / (bx * cz - bz * cx);
+
+		double dx = (cz * bl - bz * cl) * d;
+		double dz = (bx * cl - cx * bl) * d;
+
+		x = a.x + dx;
+		z = a.z + dz;
+
+		return dx * dx + dz * dz;
+	}
+};
+
+const uint32_t DelaunaySweepHull::INVALID_INDEX;
+
+#endif // !DELAUNAY_SWEEP_HULL_H
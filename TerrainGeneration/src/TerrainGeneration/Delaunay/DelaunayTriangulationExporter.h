@@ -1,9 +1,10 @@
 #ifndef DELAUNAY_TRIANGULATION_EXPORTER
 #define DELAUNAY_TRIANGULATION_EXPORTER
 
-#include "DelaunayStructures.h"
+#include "DelaunayMesh.h"
 
 #include <fstream>
+#include <string>
 
 enum class TriangulationExportFormat
 {
@@ -12,12 +13,17 @@ enum class TriangulationExportFormat
 
 class DelaunayTriangulationExporter
 {
+	// file of the streamed export
+	std::ofstream streamFile;
+	std::string streamFilename;
+	bool streamRegisterNewFile = false;
+
 public:
 	DelaunayTriangulationExporter() {};
 	~DelaunayTriangulationExporter() {};
 
 	// Export
-	void Export(TriangulationExportFormat format, std::vector<DelaunayTriangle*>& triangulation, std::string& filename, bool registerNewFile)
+	void Export(TriangulationExportFormat format, const DelaunayMesh& triangulation, const std::string& filename, bool registerNewFile)
 	{
 		switch (format)
 		{
@@ -27,10 +33,64 @@ public:
 		}
 	}
 
+	// Begin a streamed export: the vertices and the triangles are written as they come, so the triangulation never has to
+	// be in memory as a whole. A vertex has to be streamed before the triangles that use it, which refer to the vertices by
+	// the order in which they were streamed
+	bool BeginStream(TriangulationExportFormat format, const std::string& filename, bool registerNewFile)
+	{
+		EndStream();
+
+		switch (format)
+		{
+		case TriangulationExportFormat::WAVEFRONT_OBJ:
+			streamFilename = "assets/Triangulations/" + filename + ".obj";
+			streamFile.open(streamFilename);
+			if (!streamFile.is_open())
+			{
+				return false;
+			}
+
+			streamFile << "# Delaunay triangulation (streamed: every vertex comes before the first face that uses it)" << std::endl << std::endl;
+			break;
+		}
+
+		streamRegisterNewFile = registerNewFile;
+
+		return true;
+	}
+
+	// Stream vertex
+	void StreamVertex(const glm::vec3& v)
+	{
+		ExportVertexToWavefronObj(streamFile, v);
+	}
+
+	// Stream triangle
+	void StreamTriangle(uint32_t v1, uint32_t v2, uint32_t v3)
+	{
+		ExportFaceToWavefronObj(streamFile, v1, v2, v3);
+	}
+
+	// End the streamed export (if any)
+	void EndStream()
+	{
+		if (!streamFile.is_open())
+		{
+			return;
+		}
+
+		streamFile.close();
+
+		if (streamRegisterNewFile)
+		{
+			RegisterNewFile(streamFilename);
+		}
+	}
+
 private:
 
 	// Export to Wavefront .obj
-	void ExportToWavefrontObj(std::vector<DelaunayTriangle*>& triangulation, std::string& filename, bool registerNewFile)
+	void ExportToWavefrontObj(const DelaunayMesh& triangulation, const std::string& filename, bool registerNewFile)
 	{
 		std::string _filename = "assets/Triangulations/" + filename + ".obj";
 		std::ofstream file(_filename);
@@ -43,23 +103,16 @@ private:
 
 		file << "# vertices (x, y, z)" << std::endl << std::endl;
 
-		unsigned numVertices = 0;
-		for (auto& triangle : triangulation)
+		for (uint32_t vertex = 0; vertex < triangulation.NumVertices(); vertex++)
 		{
-			DelaunayVertex* v1 = triangle->edge->v;
-			DelaunayVertex* v2 = triangle->edge->next->v;
-			DelaunayVertex* v3 = triangle->edge->next->next->v;
-
-			ExportVertexToWavefronObj(file, v1, numVertices);
-			ExportVertexToWavefronObj(file, v2, numVertices);
-			ExportVertexToWavefronObj(file, v3, numVertices);
+			ExportVertexToWavefronObj(file, triangulation.Position(vertex));
 		}
 
 		file << std::endl << "# faces" << std::endl << std::endl;
 
-		for (auto& triangle : triangulation)
+		for (uint32_t triangle = 0; triangle < triangulation.NumTriangles(); triangle++)
 		{
-			ExportFaceToWavefronObj(file, triangle);
+			ExportFaceToWavefronObj(file, triangulation, triangle);
 		}
 
 		file.close();
@@ -67,39 +120,42 @@ private:
 		// register new file
 		if (registerNewFile)
 		{
-			std::ofstream outfile;
-
-			outfile.open("assets/Triangulations/triangulations.txt", std::ios_base::app);
-			if (outfile)
-			{
-				outfile << std::endl << _filename;
-			}
+			RegisterNewFile(_filename);
 		}
 	}
 
-	// Export vertex Wavefront .obj
-	void ExportVertexToWavefronObj(std::ofstream& file, DelaunayVertex* vertex, unsigned& numVertices)
+	// Register new file
+	void RegisterNewFile(const std::string& filename)
 	{
-		if (vertex->exportIndex == -1)
-		{
-			vertex->exportIndex = numVertices++;
-
-			const glm::vec3& v = vertex->v;
+		std::ofstream outfile;
 
-			file << "v " << v.x << " " << v.y << " " << v.z << std::endl;
+		outfile.open("assets/Triangulations/triangulations.txt", std::ios_base::app);
+		if (outfile)
+		{
+			outfile << std::endl << filename;
 		}
 	}
 
+	// Export vertex Wavefront .obj
+	void ExportVertexToWavefronObj(std::ofstream& file, const glm::vec3& v)
+	{
+		file << "v " << v.x << " " << v.y << " " << v.z << std::endl;
+	}
+
 	// Export face to Wavefront .obj
-	void ExportFaceToWavefronObj(std::ofstream& file, DelaunayTriangle* triangle)
+	void ExportFaceToWavefronObj(std::ofstream& file, const DelaunayMesh& triangulation, uint32_t triangle)
 	{
-		DelaunayVertex* v1 = triangle->edge->v;
-		DelaunayVertex* v2 = triangle->edge->next->v;
-		DelaunayVertex* v3 = triangle->edge->next->next->v;
+		uint32_t v1 = triangulation.TriangleVertex(triangle, 0);
+		uint32_t v2 = triangulation.TriangleVertex(triangle, 1);
+		uint32_t v3 = triangulation.TriangleVertex(triangle, 2);
 
-		file << "f " << v1->exportIndex << " " << v2->exportIndex << " " << v3->exportIndex << std::endl;
+		ExportFaceToWavefronObj(file, v1, v2, v3);
+	}
+
+	void ExportFaceToWavefronObj(std::ofstream& file, uint32_t v1, uint32_t v2, uint32_t v3)
+	{
+		file << "f " << v1 << " " << v2 << " " << v3 << std::endl;
 	}
 };
 
 #endif // !TRIANGULATION_EXPORTER
-
@@ -0,0 +1,217 @@
+#ifndef DELAUNAY_VORONOI_H
+#define DELAUNAY_VORONOI_H
+
+#include "glm/glm.hpp"
+#include "../../Geom2DTest/Geom2DTest.h"
+#include "../../Parallel/Parallel.h"
+#include "DelaunayMesh.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Voronoi diagram of a triangulation (its dual) stored as flat arrays, clipped to a box.
+//
+// The cell of vertex v of the triangulation is the polygon whose vertices are [cellOffsets[v], cellOffsets[v + 1]) of
+// the cell vertices, clockwise in the xz plane like the triangles (empty when the cell is out of the box). The vertices of
+// the Voronoi diagram are the circumcenters of the triangles, so the cells inside the box share them
+struct DelaunayVoronoi
+{
+	// circumcenter of every triangle of the triangulation (x, z)
+	std::vector<glm::vec2> circumcenters;
+
+	// cells: their polygons, one after another, and where each of them starts (with the end of the last one at the end)
+	std::vector<glm::vec2> cellVertices;
+	std::vector<uint32_t> cellOffsets;
+
+	// Clear
+	void Clear()
+	{
+		circumcenters.clear();
+		cellVertices.clear();
+		cellOffsets.clear();
+	}
+
+	// Build the Voronoi diagram of the triangulation clipped to the box. The circumcenters and then the cells are built in
+	// parallel, every block of cells into its own buffer, which is copied to its place once the sizes of the blocks are
+	// known. The cells around the vertices inside the triangulation are the circumcenters of the triangles around them,
+	// clipped to the box. The cells of the convex hull vertices are open, so they are the box clipped by the bisectors
+	// between the vertex and each of its neighbors
+	void Build(const DelaunayMesh& mesh, const glm::vec3& topLeft, const glm::vec3& bottomRight)
+	{
+		const size_t minBlockSize = 1 << 12;
+
+		circumcenters.resize(mesh.NumTriangles());
+		Parallel::For(0, mesh.NumTriangles(), minBlockSize, [this, &mesh](size_t triangle)
+		{
+			glm::vec3 center;
+			float radius;
+			Geom2DTest::TriangleCircumcenter(mesh.Position(mesh.TriangleVertex((uint32_t)triangle, 0)), mesh.Position(mesh.TriangleVertex((uint32_t)triangle, 1)),
+				mesh.Position(mesh.TriangleVertex((uint32_t)triangle, 2)), center, radius);
+
+			circumcenters[triangle] = glm::vec2(center.x, center.z);
+		});
+
+		// half-edge leaving every vertex, the one on the convex hull for the vertices on it (the rotation starts there)
+		std::vector<uint32_t> vertexEdges(mesh.NumVertices(), DelaunayMesh::INVALID_INDEX);
+		for (uint32_t edge = 0; edge < mesh.NumHalfEdges(); edge++)
+		{
+			uint32_t& vertexEdge = vertexEdges[mesh.origins[edge]];
+			if (vertexEdge == DelaunayMesh::INVALID_INDEX || mesh.twins[edge] == DelaunayMesh::INVALID_INDEX)
+			{
+				vertexEdge = edge;
+			}
+		}
+
+		// box, clockwise
+		Polygon box = {
+			glm::dvec2(topLeft.x, topLeft.z), glm::dvec2(topLeft.x, bottomRight.z),
+			glm::dvec2(bottomRight.x, bottomRight.z), glm::dvec2(bottomRight.x, topLeft.z) };
+
+		std::vector< std::vector<glm::vec2> > blockVertices(Parallel::NumThreads());
+		std::vector< std::vector<uint32_t> > blockSizes(Parallel::NumThreads());
+
+		size_t numBlocks = Parallel::ForBlocks(0, mesh.NumVertices(), minBlockSize, [&](size_t blockBegin, size_t blockEnd, size_t block)
+		{
+			Polygon cell;
+			Polygon clipped;
+			for (size_t vertex = blockBegin; vertex < blockEnd; vertex++)
+			{
+				BuildCell(mesh, (uint32_t)vertex, vertexEdges[vertex], box, cell, clipped);
+
+				for (auto& cellVertex : cell)
+				{
+					blockVertices[block].push_back(glm::vec2(cellVertex));
+				}
+				blockSizes[block].push_back((uint32_t)cell.size());
+			}
+		});
+
+		// first cell vertex of every block
+		std::vector<uint32_t> blockOffsets(numBlocks + 1, 0);
+		for (size_t block = 0; block < numBlocks; block++)
+		{
+			blockOffsets[block + 1] = blockOffsets[block] + (uint32_t)blockVertices[block].size();
+		}
+
+		cellVertices.resize(blockOffsets[numBlocks]);
+		cellOffsets.resize(mesh.NumVertices() + 1);
+		cellOffsets[mesh.NumVertices()] = blockOffsets[numBlocks];
+
+		Parallel::ForBlocks(0, mesh.NumVertices(), minBlockSize, [&](size_t blockBegin, size_t, size_t block)
+		{
+			uint32_t offset = blockOffsets[block];
+			for (size_t i = 0; i < blockSizes[block].size(); i++)
+			{
+				cellOffsets[blockBegin + i] = offset;
+				offset += blockSizes[block][i];
+			}
+
+			std::copy(blockVertices[block].begin(), blockVertices[block].end(), cellVertices.begin() + blockOffsets[block]);
+		});
+	}
+
+	// getters
+	uint32_t NumCells() const { return cellOffsets.empty() ? 0 : (uint32_t)cellOffsets.size() - 1; }
+	uint32_t CellSize(uint32_t cell) const { return cellOffsets[cell + 1] - cellOffsets[cell]; }
+	const glm::vec2& CellVertex(uint32_t cell, uint32_t i) const { return cellVertices[cellOffsets[cell] + i]; }
+
+private:
+
+	typedef std::vector<glm::dvec2> Polygon;
+
+	// Build the cell of the vertex (starting the rotation around it at the edge given) clipped to the box
+	void BuildCell(const DelaunayMesh& mesh, uint32_t vertex, uint32_t firstEdge, const Polygon& box, Polygon& cell, Polygon& clipped) const
+	{
+		cell.clear();
+		if (firstEdge == DelaunayMesh::INVALID_INDEX)
+		{
+			return;
+		}
+
+		glm::dvec2 position(mesh.positions[vertex]);
+
+		// the rotation goes across the edge that ends at the vertex in every triangle, so the triangles (and their
+		// circumcenters) come clockwise
+		if (mesh.twins[firstEdge] != DelaunayMesh::INVALID_INDEX)
+		{
+			uint32_t edge = firstEdge;
+			do
+			{
+				cell.push_back(glm::dvec2(circumcenters[mesh.faces[edge]]));
+				edge = mesh.twins[mesh.nexts[mesh.nexts[edge]]];
+			} while (edge != firstEdge && edge != DelaunayMesh::INVALID_INDEX);
+
+			if (edge == firstEdge)
+			{
+				ClipPolygonToBox(box, cell, clipped);
+				return;
+			}
+		}
+
+		// on the convex hull: the box is clipped by the half-plane closer to the vertex than to every neighbor
+		cell = box;
+
+		uint32_t edge = firstEdge;
+		while (edge != DelaunayMesh::INVALID_INDEX)
+		{
+			uint32_t previousEdge = mesh.nexts[mesh.nexts[edge]];
+
+			ClipPolygonToBisector(position, glm::dvec2(mesh.positions[mesh.origins[mesh.nexts[edge]]]), cell, clipped);
+			if (mesh.twins[previousEdge] == DelaunayMesh::INVALID_INDEX)
+			{
+				// the last neighbor, across the convex hull edge that ends at the vertex
+				ClipPolygonToBisector(position, glm::dvec2(mesh.positions[mesh.origins[previousEdge]]), cell, clipped);
+			}
+
+			edge = mesh.twins[previousEdge];
+		}
+	}
+
+	// Clip the convex polygon to the box
+	void ClipPolygonToBox(const Polygon& box, Polygon& polygon, Polygon& clipped) const
+	{
+		for (size_t i = 0; i < box.size() && !polygon.empty(); i++)
+		{
+			// the box is clockwise, so its inside is on the right of every side
+			const glm::dvec2& a = box[i];
+			const glm::dvec2& b = box[(i + 1) % box.size()];
+			ClipPolygonToHalfPlane(glm::dvec2(b.y - a.y, a.x - b.x), a, polygon, clipped);
+		}
+	}
+
+	// Clip the convex polygon to the half-plane of the points closer to the vertex than to the neighbor
+	void ClipPolygonToBisector(const glm::dvec2& vertex, const glm::dvec2& neighbor, Polygon& polygon, Polygon& clipped) const
+	{
+		ClipPolygonToHalfPlane(vertex - neighbor, 0.5 * (vertex + neighbor), polygon, clipped);
+	}
+
+	// Clip the convex polygon to the half-plane of the points p with dot(p - point, normal) >= 0 (Sutherland-Hodgman)
+	void ClipPolygonToHalfPlane(const glm::dvec2& normal, const glm::dvec2& point, Polygon& polygon, Polygon& clipped) const
+	{
+		clipped.clear();
+
+		for (size_t i = 0; i < polygon.size(); i++)
+		{
+			const glm::dvec2& a = polygon[i];
+			const glm::dvec2& b = polygon[(i + 1) % polygon.size()];
+
+			double sideA = glm::dot(a - point, normal);
+			double sideB = glm::dot(b - point, normal);
+
+			if (sideA >= 0.0)
+			{
+				clipped.push_back(a);
+			}
+
+			if ((sideA >= 0.0) != (sideB >= 0.0))
+			{
+				clipped.push_back(a + (b - a) * (sideA / (sideA - sideB)));
+			}
+		}
+
+		polygon.swap(clipped);
+	}
+};
+
+#endif // !DELAUNAY_VORONOI_H
@@ -3,13 +3,24 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <random>
 #include <vector>
 
 #include "glm/glm.hpp"
 
+#include "../../Parallel/Parallel.h"
 #include "../Heightmap/Heightmap.h"
 
+// How the heights of the points snapped together are merged
+enum class PointCloudMergePolicy
+{
+	KEEP_FIRST,		// the height of the first of them (in the order they were added)
+	AVERAGE,		// the average of their heights
+	MAX				// the maximum of their heights
+};
+
 class PointCloud
 {
 	// maximum points allowed
@@ -125,6 +136,174 @@ public:
 		bottomRight.z = bboxBottomRight.z + expansion;
 	}
 
+	// Snap together the points closer than the tolerance (in the xz plane), so the triangulation does not get duplicated
+	// or nearly duplicated points. Returns the number of points removed.
+	//
+	// Every point goes to a cell of a grid of twice the size of the tolerance, and the points are sorted by the hash of their
+	// cell, so the points close to one are in the cells its tolerance overlaps: its own and at most the 3 around the corner
+	// of the cell closest to it. The cells and the distances are computed in double, and the cells overlapped come from the
+	// same rounding as the cells of the points, so no point within the tolerance is missed far from the origin. The hash keeps
+	// the cells of an 8x8 tile in consecutive buckets, so most of the cells around one are close in memory. A point is kept
+	// unless a kept point is within the tolerance, and then it is merged into the closest one. The cells are decided in 4
+	// passes, by the parity of their coordinates, so the cells of a pass (at least 2 cells apart) can be decided in parallel:
+	// the ones they look at were decided in the previous passes. The result does not depend on the number of threads
+	size_t RemoveDuplicates(float tolerance, PointCloudMergePolicy policy)
+	{
+		const size_t minBlockSize = 1 << 12;
+
+		size_t numPoints = points.size();
+		if (numPoints < 2 || !(tolerance > 0.0f))
+		{
+			return 0;
+		}
+
+		size_t numBuckets = 1 << 6;
+		while (numBuckets < numPoints)
+		{
+			numBuckets <<= 1;
+		}
+
+		// the points by the bucket of their cell (stable, so in order inside each bucket)
+		double cellSize = 2.0 * tolerance;
+		std::vector<uint64_t> items(numPoints);
+		Parallel::For(0, numPoints, minBlockSize, [&](size_t point)
+		{
+			SnapCell cell = GetSnapCell(points[point], cellSize);
+			items[point] = ((uint64_t)SnapBucket(cell.x, cell.z, numBuckets) << 32) | point;
+		});
+
+		Parallel::RadixSortByKey(items.data(), numPoints);
+
+		// from here on the points are referred to by their slot in the sorted order, with their data in that order
+		std::vector<glm::vec3> slotPoints(numPoints);
+		std::vector<SnapCell> slotCells(numPoints);
+		std::vector<uint32_t> bucketOffsets(numBuckets + 1);
+		Parallel::For(0, numPoints + 1, minBlockSize, [&](size_t slot)
+		{
+			if (slot < numPoints)
+			{
+				slotPoints[slot] = points[(uint32_t)items[slot]];
+				slotCells[slot] = GetSnapCell(slotPoints[slot], cellSize);
+			}
+
+			size_t firstBucket = (slot == 0) ? 0 : (size_t)(items[slot - 1] >> 32) + 1;
+			size_t lastBucket = (slot == numPoints) ? numBuckets : (size_t)(items[slot] >> 32);
+			for (size_t bucket = firstBucket; bucket <= lastBucket; bucket++)
+			{
+				bucketOffsets[bucket] = (uint32_t)slot;
+			}
+		});
+
+		// the slot every slot is merged into (itself when it is kept)
+		std::vector<uint32_t> leaders(numPoints, UNDECIDED);
+
+		// calls function(other) for every slot in the cells the slot given can be within the tolerance of
+		auto forEachSlotAround = [&](uint32_t slot, auto function)
+		{
+			SnapCell first = GetSnapCell(slotPoints[slot], cellSize, -tolerance);
+			SnapCell last = GetSnapCell(slotPoints[slot], cellSize, tolerance);
+
+			for (int64_t z = first.z; z <= last.z; z++)
+			{
+				for (int64_t x = first.x; x <= last.x; x++)
+				{
+					size_t bucket = SnapBucket(x, z, numBuckets);
+					for (uint32_t other = bucketOffsets[bucket]; other < bucketOffsets[bucket + 1]; other++)
+					{
+						if (slotCells[other].x == x && slotCells[other].z == z)
+						{
+							function(other);
+						}
+					}
+				}
+			}
+		};
+
+		for (int parity = 0; parity < 4; parity++)
+		{
+			Parallel::For(0, numBuckets, minBlockSize, [&](size_t bucket)
+			{
+				for (uint32_t slot = bucketOffsets[bucket]; slot < bucketOffsets[bucket + 1]; slot++)
+				{
+					const SnapCell& cell = slotCells[slot];
+					if ((int)(cell.x & 1) + 2 * (int)(cell.z & 1) != parity)
+					{
+						continue;
+					}
+
+					uint32_t leader = slot;
+					double leaderSqrDistance = (double)tolerance * tolerance;
+					forEachSlotAround(slot, [&](uint32_t other)
+					{
+						if (leaders[other] == other && IsWithinSnapCells(slotPoints[slot], slotPoints[other], tolerance))
+						{
+							double sqrDistance = SqrDistanceXZ(slotPoints[slot], slotPoints[other]);
+							if (sqrDistance <= leaderSqrDistance)
+							{
+								leader = other;
+								leaderSqrDistance = sqrDistance;
+							}
+						}
+					});
+
+					leaders[slot] = leader;
+				}
+			});
+		}
+
+		// merge the heights into the kept points, gathering the points merged into each of them
+		std::vector<uint8_t> kept(numPoints, 0);
+		Parallel::For(0, numPoints, minBlockSize, [&](size_t slot)
+		{
+			if (leaders[slot] != slot)
+			{
+				return;
+			}
+
+			uint32_t first = (uint32_t)items[slot];
+			float firstHeight = slotPoints[slot].y;
+			float sum = 0.0f;
+			float max = slotPoints[slot].y;
+			uint32_t count = 0;
+			forEachSlotAround(slot, [&](uint32_t other)
+			{
+				if (leaders[other] == slot)
+				{
+					if ((uint32_t)items[other] < first)
+					{
+						first = (uint32_t)items[other];
+						firstHeight = slotPoints[other].y;
+					}
+					sum += slotPoints[other].y;
+					max = std::max(max, slotPoints[other].y);
+					count++;
+				}
+			});
+
+			switch (policy)
+			{
+			case PointCloudMergePolicy::KEEP_FIRST: points[first].y = firstHeight; break;
+			case PointCloudMergePolicy::AVERAGE: points[first].y = sum / count; break;
+			case PointCloudMergePolicy::MAX: points[first].y = max; break;
+			}
+
+			// the merged point takes the place of the first point of the group in the cloud, at the kept position
+			points[first].x = slotPoints[slot].x;
+			points[first].z = slotPoints[slot].z;
+			kept[first] = 1;
+		});
+
+		// the merged points, in the order they were added (the sorted points are not needed anymore)
+		size_t numKept = Parallel::Compact(numPoints, minBlockSize, [&kept](size_t point) { return kept[point] != 0; },
+			[this, &slotPoints](size_t point, size_t index) { slotPoints[index] = points[point]; });
+
+		slotPoints.resize(numKept);
+		points.swap(slotPoints);
+		UpdateBoundingBox();
+
+		return numPoints - numKept;
+	}
+
 	void CreateCustomTest()
 	{
 		// clear current set
@@ -138,6 +317,69 @@ public:
 	}
 
 private:
+
+	// point not decided yet by RemoveDuplicates
+	static const uint32_t UNDECIDED = 0xFFFFFFFF;
+
+	// cell of the snapping grid
+	struct SnapCell
+	{
+		int64_t x, z;
+	};
+
+	// Cell of the point (moved by the offset along both axes) in the snapping grid
+	SnapCell GetSnapCell(const glm::vec3& point, double cellSize, double offset = 0.0) const
+	{
+		SnapCell cell;
+		cell.x = (int64_t)std::floor(((double)point.x - bboxTopLeft.x + offset) / cellSize);
+		cell.z = (int64_t)std::floor(((double)point.z - bboxTopLeft.z + offset) / cellSize);
+
+		return cell;
+	}
+
+	// Are the points within the tolerance along both axes, so each one is in the cells the other one looks at
+	static bool IsWithinSnapCells(const glm::vec3& a, const glm::vec3& b, double tolerance)
+	{
+		return std::abs((double)a.x - b.x) <= tolerance && std::abs((double)a.z - b.z) <= tolerance;
+	}
+
+	// Bucket of the cell: the hash of its 8x8 tile followed by its position in the tile (the buckets are a power of 2,
+	// at least 64)
+	static size_t SnapBucket(int64_t x, int64_t z, size_t numBuckets)
+	{
+		uint64_t hash = (uint64_t)(x >> 3) * 0x9E3779B97F4A7C15ull ^ (uint64_t)(z >> 3) * 0xC2B2AE3D27D4EB4Full;
+		hash ^= hash >> 32;
+
+		return (size_t)((hash << 6) | ((z & 7) << 3) | (x & 7)) & (numBuckets - 1);
+	}
+
+	// Square distance between the points in the xz plane
+	static double SqrDistanceXZ(const glm::vec3& a, const glm::vec3& b)
+	{
+		double dx = (double)a.x - b.x;
+		double dz = (double)a.z - b.z;
+
+		return dx * dx + dz * dz;
+	}
+
+	// Update the bounding box to the points
+	void UpdateBoundingBox()
+	{
+		if (points.empty())
+		{
+			return;
+		}
+
+		bboxTopLeft = bboxBottomRight = points[0];
+		for (auto& point : points)
+		{
+			bboxTopLeft.x = std::min(bboxTopLeft.x, point.x);
+			bboxBottomRight.x = std::max(bboxBottomRight.x, point.x);
+
+			bboxTopLeft.z = std::min(bboxTopLeft.z, point.z);
+			bboxBottomRight.z = std::max(bboxBottomRight.z, point.z);
+		}
+	}
 	
 	// Init 
 	void Init()
@@ -156,5 +398,7 @@ private:
 	}
 };
 
+const uint32_t PointCloud::UNDECIDED;
+
 #endif // !POINT_CLOUD_H
 
@@ -22,6 +22,10 @@ class TerrainGeneration : public InputListener
 	// point cloud
 	PointCloud pointCloud;
 
+	// the points of the point cloud closer than this are snapped together when it is created, so every triangulation of it
+	// (by iterations too) indexes the same points
+	float pointCloudSnapTolerance = 1e-4f;
+
 	// Delaunay triangulation
 	Delaunay delaunay;
 
@@ -144,6 +148,9 @@ protected:
 
 		// load triangulations
 		LoadTriangulations();
+
+		// triangulate in one shot with the fastest engine (the step by step triangulation stays incremental)
+		delaunay.SetAlgorithm(DelaunayAlgorithm::SWEEP_HULL);
 	}
 		
 	void InitVBO()
@@ -278,11 +285,15 @@ protected:
 			const glm::mat4& viewProjection = camera.ViewProjectionMatrix();
 
 			auto& triangulation = delaunay.Triangulation();
-			if (triangulation.size() > 0)
+			if (triangulation.NumTriangles() > 0)
 			{
-				for (auto& triangle : triangulation)
+				for (uint32_t triangle = 0; triangle < triangulation.NumTriangles(); triangle++)
 				{
-					DrawDelaunayTriangle(*triangle, viewProjection, shader);
+					const glm::vec3 v1 = triangulation.Position(triangulation.TriangleVertex(triangle, 0));
+					const glm::vec3 v2 = triangulation.Position(triangulation.TriangleVertex(triangle, 1));
+					const glm::vec3 v3 = triangulation.Position(triangulation.TriangleVertex(triangle, 2));
+
+					DrawDelaunayTriangle(v1, v2, v3, viewProjection, shader);
 				}
 			}
 			else
@@ -296,26 +307,27 @@ protected:
 
 	void DrawDelaunayTriangleLeafs(const DelaunayTriangle& triangle, const glm::mat4& viewProjection, Shader& shader)
 	{
-		auto& children = triangle.children;
-		if (children.size() == 0)
+		if (triangle.IsLeaf())
 		{
-			DrawDelaunayTriangle(triangle, viewProjection, shader);
+			// a root triangle restored from a snapshot keeps only its vertices
+			if (!triangle.edge)
+			{
+				return;
+			}
+
+			DrawDelaunayTriangle(triangle.edge->v->v, triangle.edge->next->v->v, triangle.edge->next->next->v->v, viewProjection, shader);
 		}
 		else
 		{
-			for (size_t i = 0; i < children.size(); i++)
+			for (int i = 0; i < triangle.numChildren; i++)
 			{
-				DrawDelaunayTriangleLeafs(*children[i], viewProjection, shader);
+				DrawDelaunayTriangleLeafs(*triangle.children[i], viewProjection, shader);
 			}
 		}
 	}
 
-	void DrawDelaunayTriangle(const DelaunayTriangle& triangle, const glm::mat4& viewProjection, Shader& shader)
+	void DrawDelaunayTriangle(const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& v3, const glm::mat4& viewProjection, Shader& shader)
 	{
-		const glm::vec3& v1 = triangle.edge->v->v;
-		const glm::vec3& v2 = triangle.edge->next->v->v;
-		const glm::vec3& v3 = triangle.edge->next->next->v->v;
-
 		// use the shader
 		shader.Use();
 
@@ -394,6 +406,7 @@ protected:
 	{
 		Clear();
 		pointCloud.CreateCustomTest();
+		pointCloud.RemoveDuplicates(pointCloudSnapTolerance, PointCloudMergePolicy::AVERAGE);
 		mode = Mode::NONE;
 	}
 
@@ -401,6 +414,7 @@ protected:
 	{
 		Clear();
 		pointCloud.CreateRandom(pointCloudMin, pointCloudMax);
+		pointCloud.RemoveDuplicates(pointCloudSnapTolerance, PointCloudMergePolicy::AVERAGE);
 		mode = Mode::NONE;
 	}
 
@@ -410,6 +424,7 @@ protected:
 		{
 			Clear();
 			pointCloud.CreateFromHeightMap(heightMaps[currentHeightMap], glm::vec3(-20.0f, 0.0f, pointCloudMin.z));
+			pointCloud.RemoveDuplicates(pointCloudSnapTolerance, PointCloudMergePolicy::AVERAGE);
 			mode = Mode::HEIGHTMAP_POINT_CLOUD_VIEWER;
 		}
 	}